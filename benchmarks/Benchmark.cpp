@@ -0,0 +1,43 @@
+//------------------------------------------------------------------------------
+// Benchmark.cpp
+// Minimal harness for timing slang components.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#include "Benchmark.h"
+
+namespace slang::bench {
+
+bool State::keepRunning() {
+    auto now = Clock::now();
+    if (!started) {
+        started = true;
+        start = now;
+        return true;
+    }
+
+    iterations_++;
+    elapsed = std::chrono::duration<double>(now - start).count();
+    return elapsed < minSeconds;
+}
+
+void State::setCounter(const std::string& name, double value) {
+    for (auto& counter : counters_) {
+        if (counter.first == name) {
+            counter.second = value;
+            return;
+        }
+    }
+    counters_.emplace_back(name, value);
+}
+
+std::vector<BenchmarkInfo>& getBenchmarks() {
+    static std::vector<BenchmarkInfo> benchmarks;
+    return benchmarks;
+}
+
+Registration::Registration(const char* name, BenchmarkFunc func) {
+    getBenchmarks().push_back({ name, func });
+}
+
+} // namespace slang::bench
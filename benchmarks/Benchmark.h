@@ -0,0 +1,90 @@
+//------------------------------------------------------------------------------
+// Benchmark.h
+// Minimal harness for timing slang components.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace slang::bench {
+
+/// Tracks the iterations of a single running benchmark. Benchmark functions
+/// loop on keepRunning() and report how much input they consumed per iteration
+/// so that throughput can be computed.
+///
+/// Benchmarks generate their inputs when they start running; the size of those
+/// inputs is controlled by a scale factor that is passed in by the harness.
+class State {
+public:
+    State(double minSeconds, double scale) : minSeconds(minSeconds), scale(scale) {}
+
+    /// Scales a nominal input size by the requested factor, never going below one.
+    int scaled(int size) const { return std::max(1, int(size * scale)); }
+
+    /// Returns true if another iteration should be run. The first call starts the clock.
+    bool keepRunning();
+
+    /// Records that @a bytes of input were processed by the current iteration.
+    void addBytesProcessed(uint64_t bytes) { bytes_ += bytes; }
+
+    /// Sets a named value to report alongside the timing results, such as
+    /// memory usage. Setting the same name again replaces the old value.
+    void setCounter(const std::string& name, double value);
+
+    uint64_t iterations() const { return iterations_; }
+    uint64_t bytesProcessed() const { return bytes_; }
+    double elapsedSeconds() const { return elapsed; }
+    const std::vector<std::pair<std::string, double>>& counters() const { return counters_; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::vector<std::pair<std::string, double>> counters_;
+    Clock::time_point start;
+    double minSeconds;
+    double scale;
+    double elapsed = 0.0;
+    uint64_t iterations_ = 0;
+    uint64_t bytes_ = 0;
+    bool started = false;
+};
+
+using BenchmarkFunc = void (*)(State&);
+
+/// Registers a benchmark to be run by the harness; used via the BENCHMARK macro.
+struct Registration {
+    Registration(const char* name, BenchmarkFunc func);
+};
+
+struct BenchmarkInfo {
+    std::string name;
+    BenchmarkFunc func;
+};
+
+/// Gets the list of all registered benchmarks, in registration order.
+std::vector<BenchmarkInfo>& getBenchmarks();
+
+/// Prevents the compiler from optimizing away the computation of @a value.
+template<typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+}
+
+} // namespace slang::bench
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+
+#define BENCHMARK(name, func)                                                              \
+    static ::slang::bench::Registration BENCH_CONCAT(benchReg_, __LINE__)(name, func)
@@ -0,0 +1,42 @@
+//------------------------------------------------------------------------------
+// CompilationBenchmarks.cpp
+// Elaboration benchmarks.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#include "Benchmark.h"
+#include "SourceGenerators.h"
+
+#include "slang/compilation/Compilation.h"
+#include "slang/syntax/SyntaxTree.h"
+#include "slang/text/SourceManager.h"
+
+using namespace slang;
+using namespace slang::bench;
+
+namespace {
+
+// Parses the given text once up front and then elaborates it in a fresh
+// compilation on each iteration.
+void elaborateAll(State& state, const std::string& text) {
+    SourceManager sourceManager;
+    auto tree = SyntaxTree::fromText(text, sourceManager);
+
+    while (state.keepRunning()) {
+        Compilation compilation;
+        compilation.addSyntaxTree(tree);
+        doNotOptimize(compilation.getRoot());
+        state.addBytesProcessed(text.size());
+    }
+}
+
+void elaborateHierarchy(State& state) {
+    // Four levels with a fanout of four gives 85 instances per top level copy.
+    int tops = state.scaled(50);
+    elaborateAll(state, generateHierarchySource(tops, 4, 4));
+    state.setCounter("instances", double(tops * 85 + 1));
+}
+
+} // namespace
+
+BENCHMARK("Compilation/Hierarchy", elaborateHierarchy);
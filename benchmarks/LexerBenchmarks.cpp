@@ -0,0 +1,83 @@
+//------------------------------------------------------------------------------
+// LexerBenchmarks.cpp
+// Lexer throughput benchmarks.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#include "Benchmark.h"
+#include "SourceGenerators.h"
+
+#include "slang/diagnostics/Diagnostics.h"
+#include "slang/parsing/Lexer.h"
+#include "slang/text/SourceManager.h"
+#include "slang/util/BumpAllocator.h"
+
+using namespace slang;
+using namespace slang::bench;
+
+namespace {
+
+void lexAll(State& state, const std::string& text, LexerOptions options = {}) {
+    SourceManager sourceManager;
+    SourceBuffer buffer = sourceManager.assignText(text);
+
+    while (state.keepRunning()) {
+        BumpAllocator alloc;
+        Diagnostics diagnostics;
+        Lexer lexer(buffer, alloc, diagnostics, options);
+
+        size_t count = 0;
+        while (lexer.lex().kind != TokenKind::EndOfFile)
+            count++;
+
+        doNotOptimize(count);
+        state.addBytesProcessed(text.size());
+        state.setCounter("tokens", double(count));
+        state.setCounter("bytes/token", double(alloc.getBytesAllocated()) / double(count));
+    }
+}
+
+void lexCommentHeavy(State& state) {
+    std::string text = generateCommentHeavySource(state.scaled(100));
+    lexAll(state, text);
+}
+
+void lexCommentHeavyNoTrivia(State& state) {
+    std::string text = generateCommentHeavySource(state.scaled(100));
+    LexerOptions options;
+    options.preserveTrivia = false;
+    lexAll(state, text, options);
+}
+
+void lexTrivia(State& state) {
+    std::string text = generateTriviaSource(state.scaled(1000));
+    lexAll(state, text);
+}
+
+void lexDense(State& state) {
+    std::string text = generateDenseSource(state.scaled(100));
+    lexAll(state, text);
+}
+
+void lexDenseCached(State& state) {
+    // The first iteration fills the cache; every one after that replays it.
+    auto dir = fs::temp_directory_path() / "slang-bench-token-cache";
+    fs::remove_all(dir);
+
+    std::string text = generateDenseSource(state.scaled(100));
+    {
+        TokenCache cache(dir.string());
+        LexerOptions options;
+        options.tokenCache = &cache;
+        lexAll(state, text, options);
+    }
+    fs::remove_all(dir);
+}
+
+} // namespace
+
+BENCHMARK("Lexer/CommentHeavy", lexCommentHeavy);
+BENCHMARK("Lexer/CommentHeavy/NoTrivia", lexCommentHeavyNoTrivia);
+BENCHMARK("Lexer/Trivia", lexTrivia);
+BENCHMARK("Lexer/Dense", lexDense);
+BENCHMARK("Lexer/Dense/Cached", lexDenseCached);
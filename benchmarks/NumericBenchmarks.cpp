@@ -0,0 +1,73 @@
+//------------------------------------------------------------------------------
+// NumericBenchmarks.cpp
+// SVInt arithmetic and conversion benchmarks.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#include "Benchmark.h"
+
+#include "slang/numeric/SVInt.h"
+
+using namespace slang;
+using namespace slang::bench;
+
+namespace {
+
+// Makes a wide value with a varied bit pattern; @a salt selects between different ones.
+SVInt makeWideValue(int width, int salt) {
+    std::string text = std::to_string(width) + "'h";
+    for (int i = 0; i < width / 4; i++)
+        text += "0123456789abcdef"[(i * 7 + salt * 3 + 1) % 16];
+    return SVInt::fromString(text);
+}
+
+// Runs @a op a scaled number of times per iteration and reports the resulting rate.
+template<typename TFunc>
+void runOps(State& state, int nominalOps, TFunc&& op) {
+    int ops = state.scaled(nominalOps);
+    while (state.keepRunning()) {
+        for (int i = 0; i < ops; i++)
+            op();
+    }
+
+    if (state.elapsedSeconds() > 0) {
+        state.setCounter("ops/s", double(state.iterations()) * ops / state.elapsedSeconds());
+    }
+}
+
+void wideAdd(State& state) {
+    SVInt a = makeWideValue(1024, 1);
+    SVInt b = makeWideValue(1024, 2);
+    runOps(state, 10000, [&] { a = a + b; });
+    doNotOptimize(a);
+}
+
+void wideMultiply(State& state) {
+    SVInt a = makeWideValue(1024, 1);
+    SVInt b = makeWideValue(1024, 2);
+    runOps(state, 1000, [&] { doNotOptimize(a * b); });
+}
+
+void wideDivide(State& state) {
+    SVInt a = makeWideValue(1024, 1);
+    SVInt b = extend(makeWideValue(512, 2), 1024, false);
+    runOps(state, 1000, [&] { doNotOptimize(a / b); });
+}
+
+void wideFromString(State& state) {
+    std::string text = makeWideValue(1024, 3).toString(LiteralBase::Decimal);
+    runOps(state, 1000, [&] { doNotOptimize(SVInt::fromString(text)); });
+}
+
+void wideToString(State& state) {
+    SVInt a = makeWideValue(1024, 4);
+    runOps(state, 100, [&] { doNotOptimize(a.toString(LiteralBase::Decimal)); });
+}
+
+} // namespace
+
+BENCHMARK("SVInt/Add/1024", wideAdd);
+BENCHMARK("SVInt/Multiply/1024", wideMultiply);
+BENCHMARK("SVInt/Divide/1024", wideDivide);
+BENCHMARK("SVInt/FromString/1024", wideFromString);
+BENCHMARK("SVInt/ToString/1024", wideToString);
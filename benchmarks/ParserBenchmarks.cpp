@@ -0,0 +1,74 @@
+//------------------------------------------------------------------------------
+// ParserBenchmarks.cpp
+// Parser throughput benchmarks.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#include "Benchmark.h"
+#include "SourceGenerators.h"
+
+#include "slang/syntax/SyntaxTree.h"
+#include "slang/text/SourceManager.h"
+
+using namespace slang;
+using namespace slang::bench;
+
+namespace {
+
+// Builds a full syntax tree (preprocessing included) on each iteration.
+void parseAll(State& state, const std::string& text) {
+    SourceManager sourceManager;
+    SourceBuffer buffer = sourceManager.assignText(text);
+
+    while (state.keepRunning()) {
+        auto tree = SyntaxTree::fromBuffer(buffer, sourceManager);
+        doNotOptimize(tree);
+        state.addBytesProcessed(text.size());
+        state.setCounter("bytes/source byte", double(tree->allocator().getBytesAllocated()) /
+                                                   double(text.size()));
+    }
+}
+
+// Parses a set of independent buffers on all hardware threads on each iteration. Every
+// buffer interns the same identifiers, so this also shows any contention between threads
+// on the shared identifier table.
+void parseParallel(State& state, const std::string& text, size_t bufferCount) {
+    SourceManager sourceManager;
+    std::vector<SourceBuffer> buffers;
+    for (size_t i = 0; i < bufferCount; i++)
+        buffers.push_back(sourceManager.assignText(text));
+
+    while (state.keepRunning()) {
+        auto trees = SyntaxTree::fromBuffers(buffers, sourceManager);
+        doNotOptimize(trees);
+        state.addBytesProcessed(text.size() * bufferCount);
+    }
+}
+
+void parseDense(State& state) {
+    parseAll(state, generateDenseSource(state.scaled(100)));
+}
+
+void parseDenseParallel(State& state) {
+    parseParallel(state, generateDenseSource(state.scaled(25)), 16);
+}
+
+void parseCommentHeavy(State& state) {
+    parseAll(state, generateCommentHeavySource(state.scaled(100)));
+}
+
+void parseMacroHeavy(State& state) {
+    parseAll(state, generateMacroHeavySource(state.scaled(2000)));
+}
+
+void parseWideLiterals(State& state) {
+    parseAll(state, generateWideLiteralSource(state.scaled(2000), 1024));
+}
+
+} // namespace
+
+BENCHMARK("Parser/Dense", parseDense);
+BENCHMARK("Parser/Dense/Parallel", parseDenseParallel);
+BENCHMARK("Parser/CommentHeavy", parseCommentHeavy);
+BENCHMARK("Parser/MacroHeavy", parseMacroHeavy);
+BENCHMARK("Parser/WideLiterals", parseWideLiterals);
@@ -0,0 +1,161 @@
+//------------------------------------------------------------------------------
+// PreprocessorBenchmarks.cpp
+// Preprocessor throughput benchmarks.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#include "Benchmark.h"
+#include "SourceGenerators.h"
+
+#include "slang/diagnostics/Diagnostics.h"
+#include "slang/parsing/Preprocessor.h"
+#include "slang/text/SourceManager.h"
+#include "slang/util/BumpAllocator.h"
+
+using namespace slang;
+using namespace slang::bench;
+
+namespace {
+
+// Runs the given buffer through a fresh preprocessor on each iteration. Files
+// loaded via include directives are cached by the source manager after the
+// first iteration, so this measures token processing rather than file IO.
+void preprocessAll(State& state, SourceManager& sourceManager, SourceBuffer buffer,
+                   size_t totalBytes, const Bag& options = {}) {
+    while (state.keepRunning()) {
+        BumpAllocator alloc;
+        Diagnostics diagnostics;
+        Preprocessor preprocessor(sourceManager, alloc, diagnostics, options);
+        preprocessor.pushSource(buffer);
+
+        size_t count = 0;
+        while (preprocessor.next().kind != TokenKind::EndOfFile)
+            count++;
+
+        doNotOptimize(count);
+        state.addBytesProcessed(totalBytes);
+        state.setCounter("tokens", double(count));
+    }
+}
+
+void preprocessMacroHeavy(State& state) {
+    std::string text = generateMacroHeavySource(state.scaled(2000));
+    SourceManager sourceManager;
+    preprocessAll(state, sourceManager, sourceManager.assignText(text), text.size());
+}
+
+void preprocessUvmMacros(State& state) {
+    std::string text = generateUvmStyleSource(state.scaled(200));
+    SourceManager sourceManager;
+    preprocessAll(state, sourceManager, sourceManager.assignText(text), text.size());
+}
+
+void preprocessRegisterMap(State& state) {
+    std::string text = generateRegisterMapSource(256, state.scaled(20000));
+    SourceManager sourceManager;
+    preprocessAll(state, sourceManager, sourceManager.assignText(text), text.size());
+}
+
+void preprocessInactiveBranches(State& state) {
+    std::string text = generateInactiveBranchSource(state.scaled(500));
+    SourceManager sourceManager;
+    preprocessAll(state, sourceManager, sourceManager.assignText(text), text.size());
+}
+
+void preprocessDeepIncludes(State& state) {
+    SourceManager sourceManager;
+    auto includes = generateIncludeChains(sourceManager, state.scaled(16), 64);
+    preprocessAll(state, sourceManager, sourceManager.assignText(includes.top),
+                  includes.totalBytes);
+}
+
+void preprocessRepeatedIncludes(State& state) {
+    SourceManager sourceManager;
+    auto includes = generateRepeatedIncludes(sourceManager, state.scaled(200));
+    preprocessAll(state, sourceManager, sourceManager.assignText(includes.top),
+                  includes.totalBytes);
+}
+
+void preprocessCachedIncludes(State& state) {
+    // The cache outlives each iteration's preprocessor, as it would when
+    // shared between syntax trees.
+    TokenCache cache;
+    PreprocessorOptions ppOptions;
+    ppOptions.includeTokenCache = &cache;
+    Bag options;
+    options.add(ppOptions);
+
+    SourceManager sourceManager;
+    auto includes = generateRepeatedIncludes(sourceManager, state.scaled(200));
+    preprocessAll(state, sourceManager, sourceManager.assignText(includes.top),
+                  includes.totalBytes, options);
+}
+
+// Preprocesses a batch of small files that each start out with the same few hundred
+// predefined macros, as happens when every file in a design is its own compilation
+// unit. If @a useSnapshot is set the predefines are processed once up front.
+void preprocessWithPredefines(State& state, bool useSnapshot) {
+    PreprocessorOptions ppOptions;
+    for (int i = 0; i < 300; i++)
+        ppOptions.predefines.push_back("CFG_" + std::to_string(i) + "=" + std::to_string(i));
+
+    SourceManager sourceManager;
+    std::vector<SourceBuffer> buffers;
+    size_t totalBytes = 0;
+    for (int i = 0; i < state.scaled(50); i++) {
+        std::string text = "module unit" + std::to_string(i) + ";\n";
+        text += "localparam int P = `CFG_" + std::to_string(i % 300) + ";\n";
+        text += "endmodule\n";
+        totalBytes += text.size();
+        buffers.push_back(sourceManager.assignText(text));
+    }
+
+    Bag options;
+    options.add(ppOptions);
+
+    BumpAllocator snapshotAlloc;
+    Diagnostics snapshotDiags;
+    Preprocessor snapshotPP(sourceManager, snapshotAlloc, snapshotDiags, options);
+    PreprocessorSnapshot snapshot = snapshotPP.snapshot();
+
+    if (useSnapshot) {
+        PreprocessorOptions snapshotOptions;
+        snapshotOptions.snapshot = &snapshot;
+        options.add(snapshotOptions);
+    }
+
+    while (state.keepRunning()) {
+        BumpAllocator alloc;
+        Diagnostics diagnostics;
+        size_t count = 0;
+        for (auto buffer : buffers) {
+            Preprocessor preprocessor(sourceManager, alloc, diagnostics, options);
+            preprocessor.pushSource(buffer);
+            while (preprocessor.next().kind != TokenKind::EndOfFile)
+                count++;
+        }
+
+        doNotOptimize(count);
+        state.addBytesProcessed(totalBytes);
+    }
+}
+
+void preprocessPredefines(State& state) {
+    preprocessWithPredefines(state, false);
+}
+
+void preprocessSnapshot(State& state) {
+    preprocessWithPredefines(state, true);
+}
+
+} // namespace
+
+BENCHMARK("Preprocessor/MacroHeavy", preprocessMacroHeavy);
+BENCHMARK("Preprocessor/UvmMacros", preprocessUvmMacros);
+BENCHMARK("Preprocessor/RegisterMap", preprocessRegisterMap);
+BENCHMARK("Preprocessor/InactiveBranches", preprocessInactiveBranches);
+BENCHMARK("Preprocessor/DeepIncludes", preprocessDeepIncludes);
+BENCHMARK("Preprocessor/RepeatedIncludes", preprocessRepeatedIncludes);
+BENCHMARK("Preprocessor/RepeatedIncludesCached", preprocessCachedIncludes);
+BENCHMARK("Preprocessor/Predefines", preprocessPredefines);
+BENCHMARK("Preprocessor/Snapshot", preprocessSnapshot);
@@ -0,0 +1,356 @@
+//------------------------------------------------------------------------------
+// SourceGenerators.cpp
+// Synthetic SystemVerilog inputs for benchmarks.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#include "SourceGenerators.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+
+#include "slang/text/SourceManager.h"
+
+namespace fs = std::filesystem;
+
+namespace slang::bench {
+
+std::string generateCommentHeavySource(int modules) {
+    std::string result;
+    for (int m = 0; m < modules; m++) {
+        result += "/*\n";
+        for (int i = 0; i < 20; i++)
+            result += " * Copyright notice and license text that goes on for a while here.\n";
+        result += " */\n\n";
+
+        std::string name = "mod" + std::to_string(m);
+        result += "// Module " + name + " does interesting things with its inputs.\n";
+        result += "module " + name;
+        result += "(input logic clk, input logic [31:0] a, output logic [31:0] b);\n";
+        for (int i = 0; i < 50; i++) {
+            std::string n = std::to_string(i);
+            result += "        // Register stage " + n + " holds the intermediate value.\n";
+            result += "        logic [31:0]    r" + n + ";        // stage " + n + "\n";
+            result += "        always_ff @(posedge clk)\n";
+            result += "            r" + n + " <= a + 32'd" + n + ";    /* add offset */\n\n";
+        }
+        result += "endmodule\n\n";
+    }
+    return result;
+}
+
+std::string generateDenseSource(int modules) {
+    std::string result;
+    for (int m = 0; m < modules; m++) {
+        result += "module mod" + std::to_string(m) + "(input logic clk,input logic[31:0]a);\n";
+        for (int i = 0; i < 200; i++) {
+            std::string n = std::to_string(i);
+            result += "logic[31:0]r" + n + ";assign r" + n + "=a*" + n + "+(a>>2)^8'hff;\n";
+        }
+        result += "endmodule\n";
+    }
+    return result;
+}
+
+std::string generateTriviaSource(int blocks) {
+    std::string result;
+    for (int b = 0; b < blocks; b++) {
+        result += "/**\n";
+        for (int i = 0; i < 30; i++)
+            result += " * Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do.\n";
+        result += " */\n";
+        for (int i = 0; i < 30; i++)
+            result += "    //    assign disabled = some_signal & mask; // old logic\n";
+        result += "                                                                    \n";
+        result += "parameter int P" + std::to_string(b) + " = 1;\n";
+    }
+    return result;
+}
+
+std::string generateMacroHeavySource(int uses) {
+    std::string result;
+    result += "`define WIDTH 32\n";
+    result += "`define ADD(a, b) ((a) + (b))\n";
+    result += "`define MUL(a, b) ((a) * (b))\n";
+    result += "`define MAC(acc, a, b) `ADD(acc, `MUL(a, b))\n";
+    result += "`define REG(name, width = `WIDTH) logic [width-1:0] name``_q, name``_d;\n";
+    result += "`define FF(name, rst = 0) \\\n";
+    result += "    always_comb \\\n";
+    result += "        if (rst) name``_q = '0; \\\n";
+    result += "        else name``_q = name``_d;\n";
+    result += "`define STR(x) `\"x`\"\n\n";
+
+    const int usesPerModule = 100;
+    for (int u = 0; u < uses; u++) {
+        if (u % usesPerModule == 0) {
+            result += "module macros" + std::to_string(u / usesPerModule);
+            result += "(input logic clk, input logic [`WIDTH-1:0] a, b);\n";
+        }
+
+        std::string n = "sig" + std::to_string(u);
+        result += "    `REG(" + n + ")\n";
+        result += "    assign " + n + "_d = `MAC(" + n + "_q, a, `ADD(b, " + std::to_string(u) +
+                  "));\n";
+        result += "    `FF(" + n + ")\n";
+        result += "    localparam string " + n + "_name = `STR(" + n + ");\n";
+
+        if (u % usesPerModule == usesPerModule - 1 || u == uses - 1)
+            result += "endmodule\n\n";
+    }
+    return result;
+}
+
+std::string generateUvmStyleSource(int classes) {
+    std::string result;
+
+    // The real library defines on the order of a thousand macros.
+    for (int i = 0; i < 1000; i++) {
+        std::string n = std::to_string(i);
+        result += "`define UVM_LIB_MACRO_" + n + "(x) ((x) + " + n + ")\n";
+    }
+
+    result += "`define uvm_file `__FILE__\n";
+    result += "`define uvm_line `__LINE__\n";
+    result += "`define uvm_info(ID, MSG, VERBOSITY) \\\n";
+    result += "    begin \\\n";
+    result += "        if (uvm_report_enabled(VERBOSITY, UVM_INFO, ID)) \\\n";
+    result += "            uvm_report_info(ID, MSG, VERBOSITY, `uvm_file, `uvm_line, \"\", 1); "
+              "\\\n";
+    result += "    end\n";
+    result += "`define uvm_error(ID, MSG) \\\n";
+    result += "    begin \\\n";
+    result += "        if (uvm_report_enabled(UVM_NONE, UVM_ERROR, ID)) \\\n";
+    result += "            uvm_report_error(ID, MSG, UVM_NONE, `uvm_file, `uvm_line, \"\", 1); "
+              "\\\n";
+    result += "    end\n";
+    result += "`define m_uvm_field_begin(ARG, FLAG) \\\n";
+    result += "    begin \\\n";
+    result += "        case (what__) \\\n";
+    result += "            UVM_CHECK_FIELDS: "
+              "__m_uvm_status_container.do_field_check(`\"ARG`\", this);\n";
+    result += "`define m_uvm_field_op(ARG, FLAG) \\\n";
+    result += "            UVM_COPY: if (!((FLAG) & UVM_NOCOPY)) ARG = local_data__.ARG; \\\n";
+    result += "            UVM_COMPARE: if (!((FLAG) & UVM_NOCOMPARE)) \\\n";
+    result += "                void'(comparer.compare_field(`\"ARG`\", ARG, local_data__.ARG, "
+              "$bits(ARG)));\n";
+    result += "`define m_uvm_field_end(ARG) \\\n";
+    result += "        endcase \\\n";
+    result += "    end\n";
+    result += "`define uvm_field_int(ARG, FLAG) \\\n";
+    result += "    `m_uvm_field_begin(ARG, FLAG) \\\n";
+    result += "    `m_uvm_field_op(ARG, FLAG) \\\n";
+    result += "    `m_uvm_field_end(ARG)\n";
+    result += "`define uvm_object_utils_begin(T) \\\n";
+    result += "    typedef uvm_object_registry#(T, `\"T`\") type_id; \\\n";
+    result += "    function void __m_uvm_field_automation(uvm_object tmp_data__, int what__); \\\n";
+    result += "        T local_data__; \\\n";
+    result += "        $cast(local_data__, tmp_data__);\n";
+    result += "`define uvm_object_utils_end \\\n";
+    result += "    endfunction\n\n";
+
+    for (int c = 0; c < classes; c++) {
+        std::string name = "item" + std::to_string(c);
+        result += "class " + name + " extends uvm_sequence_item;\n";
+        for (int f = 0; f < 8; f++)
+            result += "    rand bit [31:0] f" + std::to_string(f) + ";\n";
+
+        result += "    `uvm_object_utils_begin(" + name + ")\n";
+        for (int f = 0; f < 8; f++)
+            result += "        `uvm_field_int(f" + std::to_string(f) + ", UVM_ALL_ON)\n";
+        result += "    `uvm_object_utils_end\n\n";
+
+        result += "    function void check();\n";
+        result += "        `uvm_info(\"" + name + "\", $sformatf(\"f0 = %0d\", f0), UVM_MEDIUM)\n";
+        result += "        if (f1 == `UVM_LIB_MACRO_" + std::to_string(c % 1000) + "(f2))\n";
+        result += "            `uvm_error(\"" + name + "\", \"f1 doesn't match\")\n";
+        result += "    endfunction\n";
+        result += "endclass\n\n";
+    }
+    return result;
+}
+
+std::string generateInactiveBranchSource(int blocks) {
+    std::string result;
+    for (int b = 0; b < blocks; b++) {
+        std::string n = std::to_string(b);
+        result += "`ifdef TARGET_FPGA_" + n + "\n";
+        for (int i = 0; i < 40; i++) {
+            std::string r = "fpga" + n + "_" + std::to_string(i);
+            result += "    // Vendor primitive wrapper for stage " + std::to_string(i) + ".\n";
+            result += "    logic [31:0] " + r + ";\n";
+            result += "    assign " + r + " = (a << " + std::to_string(i % 32) +
+                      ") ^ 32'hdead_beef;\n";
+            result += "    localparam string " + r + "_name = \"" + r + " // `endif\";\n";
+        }
+        result += "  `ifdef USE_DEBUG\n";
+        result += "    /* Debug taps, compiled in only for bring-up. */\n";
+        result += "    logic [7:0] dbg" + n + " = 8'd0;\n";
+        result += "  `endif\n";
+        result += "`elsif TARGET_EMU_" + n + "\n";
+        for (int i = 0; i < 20; i++)
+            result += "    wire emu" + n + "_" + std::to_string(i) + " = a[" +
+                      std::to_string(i) + "];\n";
+        result += "`else\n";
+        result += "parameter int P" + n + " = " + n + ";\n";
+        result += "`endif\n";
+    }
+    return result;
+}
+
+std::string generateRegisterMapSource(int registers, int uses) {
+    std::string result;
+    result += "`define REG_BASE 32'h4000_0000\n";
+    result += "`define REG_STRIDE 4\n";
+    result += "`define REG_WIDTH 32\n";
+    result += "`define REG_DATA_T logic [`REG_WIDTH-1:0]\n";
+    for (int r = 0; r < registers; r++) {
+        std::string n = std::to_string(r);
+        result += "`define REG" + n + "_ADDR (`REG_BASE + " + n + " * `REG_STRIDE)\n";
+        result += "`define REG" + n + "_RESET " + std::to_string(r * 7919 % 65536) + "\n";
+    }
+
+    result += "module regmap(input logic [31:0] addr, output logic [31:0] rdata);\n";
+    for (int u = 0; u < uses; u++) {
+        std::string n = std::to_string(u % registers);
+        result += "    `REG_DATA_T r" + std::to_string(u) + " = `REG" + n + "_RESET;\n";
+        result += "    assign rdata = (addr == `REG" + n + "_ADDR) ? r" + std::to_string(u) +
+                  " : 'z;\n";
+    }
+    result += "endmodule\n";
+    return result;
+}
+
+std::string generateWideLiteralSource(int literals, int width) {
+    // A small LCG is plenty to get digits that vary; the output has to be
+    // deterministic so that runs can be compared against each other.
+    uint64_t seed = 0x2545F4914F6CDD1Dull;
+    auto nextDigit = [&](int radix) {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        return "0123456789abcdef"[(seed >> 33) % uint64_t(radix)];
+    };
+
+    struct Base {
+        char letter;
+        int radix;
+        int digits;
+    };
+    // Sized decimal literals are limited to 32 bits, so those are kept short.
+    const Base bases[] = { { 'h', 16, width / 4 },
+                           { 'b', 2, width },
+                           { 'o', 8, width / 3 },
+                           { 'd', 10, std::min(9, width * 3 / 10) } };
+
+    std::string w = std::to_string(width);
+    std::string result = "module wide;\n";
+    for (int i = 0; i < literals; i++) {
+        auto& base = bases[i % 4];
+        result += "    localparam logic [" + w + "-1:0] p" + std::to_string(i) + " = " + w + "'";
+        result += base.letter;
+        for (int d = 0; d < base.digits; d++)
+            result += nextDigit(base.radix);
+        result += ";\n";
+    }
+    result += "endmodule\n";
+    return result;
+}
+
+std::string generateHierarchySource(int tops, int depth, int fanout) {
+    std::string result;
+    for (int level = 0; level < depth; level++) {
+        std::string name = "level" + std::to_string(level);
+        result += "module " + name + " #(parameter int W = 8)";
+        result += "(input logic clk, input logic [W-1:0] in, output logic [W-1:0] out);\n";
+
+        if (level == depth - 1) {
+            result += "    logic [W-1:0] r;\n";
+            result += "    always_comb r = in + W'(1);\n";
+            result += "    assign out = r ^ in;\n";
+        }
+        else {
+            std::string child = "level" + std::to_string(level + 1);
+            result += "    logic [W-1:0] links[" + std::to_string(fanout + 1) + "];\n";
+            result += "    assign links[0] = in;\n";
+            for (int i = 0; i < fanout; i++) {
+                std::string n = std::to_string(i);
+                result += "    " + child + " #(.W(W)) u" + n + "(.clk, .in(links[" + n +
+                          "]), .out(links[" + std::to_string(i + 1) + "]));\n";
+            }
+            result += "    assign out = links[" + std::to_string(fanout) + "];\n";
+        }
+        result += "endmodule\n\n";
+    }
+
+    result += "module top(input logic clk, input logic [15:0] in);\n";
+    for (int i = 0; i < tops; i++) {
+        std::string n = std::to_string(i);
+        result += "    logic [15:0] out" + n + ";\n";
+        result += "    level0 #(.W(16)) t" + n + "(.clk, .in, .out(out" + n + "));\n";
+    }
+    result += "endmodule\n";
+    return result;
+}
+
+GeneratedIncludes generateIncludeChains(SourceManager& sourceManager, int chains, int depth) {
+    // Overlays don't need to exist on disk, but the include paths do need to
+    // be absolute so that resolving them doesn't depend on any search paths.
+    fs::path base = fs::current_path() / "slang-bench-includes";
+    auto getPath = [&](int chain, int index) {
+        auto name = "chain" + std::to_string(chain) + "_" + std::to_string(index) + ".svh";
+        return (base / name).generic_string();
+    };
+
+    GeneratedIncludes result;
+    for (int c = 0; c < chains; c++) {
+        for (int i = 0; i < depth; i++) {
+            std::string prefix = "c" + std::to_string(c) + "_" + std::to_string(i);
+            std::string text;
+            text += "// Generated header " + std::to_string(i) + " of chain " +
+                    std::to_string(c) + ".\n";
+            text += "`define " + prefix + "_WIDTH " + std::to_string(i % 64 + 1) + "\n";
+            text += "typedef logic [`" + prefix + "_WIDTH-1:0] " + prefix + "_t;\n";
+            text += "localparam int " + prefix + "_P = " + std::to_string(i) + ";\n";
+            if (i + 1 < depth)
+                text += "`include \"" + getPath(c, i + 1) + "\"\n";
+            text += "localparam " + prefix + "_t " + prefix + "_Q = '0;\n";
+
+            result.totalBytes += text.size();
+            sourceManager.setOverlay(getPath(c, i), text);
+        }
+
+        result.top += "`include \"" + getPath(c, 0) + "\"\n";
+    }
+
+    result.top += "module includes; endmodule\n";
+    result.totalBytes += result.top.size();
+    return result;
+}
+
+GeneratedIncludes generateRepeatedIncludes(SourceManager& sourceManager, int modules) {
+    std::string path = (fs::current_path() / "slang-bench-includes" / "common_decls.svh")
+                           .generic_string();
+
+    std::string header;
+    header += "// Declarations shared by every module; deliberately not guarded.\n";
+    for (int i = 0; i < 40; i++) {
+        std::string n = std::to_string(i);
+        header += "localparam logic [31:0] COMMON_" + n + " = 32'h" + std::to_string(1000 + i) +
+                  "; // value " + n + "\n";
+        header += "typedef struct packed { logic [7:0] tag; logic [" + n +
+                  ":0] data; } common_" + n + "_t;\n";
+    }
+    sourceManager.setOverlay(path, header);
+
+    GeneratedIncludes result;
+    for (int m = 0; m < modules; m++) {
+        std::string text = "module repeated" + std::to_string(m) + ";\n";
+        text += "`include \"" + path + "\"\n";
+        text += "endmodule\n";
+
+        result.top += text;
+        result.totalBytes += text.size() + header.size();
+    }
+    return result;
+}
+
+} // namespace slang::bench
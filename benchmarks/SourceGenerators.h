@@ -0,0 +1,79 @@
+//------------------------------------------------------------------------------
+// SourceGenerators.h
+// Synthetic SystemVerilog inputs for benchmarks.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <string>
+
+namespace slang {
+
+class SourceManager;
+
+}
+
+namespace slang::bench {
+
+/// Produces source text that looks like typical hand-written RTL: deeply indented
+/// code with a license header, doc comments, and trailing line comments.
+std::string generateCommentHeavySource(int modules);
+
+/// Produces densely packed code with very little trivia.
+std::string generateDenseSource(int modules);
+
+/// Produces source text that is almost entirely comments and whitespace, such as
+/// a heavily documented package or a file that has been mostly commented out.
+std::string generateTriviaSource(int blocks);
+
+/// Produces a file that defines a library of function-like macros and then
+/// expands them many times, with nesting, token pasting, and stringification.
+std::string generateMacroHeavySource(int uses);
+
+/// Produces a file in the style of UVM testbench code: a large library of macros
+/// (in the spirit of `uvm_info and `uvm_field_int) followed by @a classes classes that
+/// use them heavily. Most of the library is never used, as is typical for UVM.
+std::string generateUvmStyleSource(int classes);
+
+/// Produces a file made up of @a blocks conditional blocks whose branches are mostly
+/// inactive, such as code for other targets or disabled debug logic. The inactive
+/// branches hold nested conditionals, comments, and strings as well as ordinary code.
+std::string generateInactiveBranchSource(int blocks);
+
+/// Produces a register map in the usual style of generated hardware headers: a block
+/// of constant macros for @a registers registers, followed by @a uses usages of them
+/// spread across the registers.
+std::string generateRegisterMapSource(int registers, int uses);
+
+/// Produces a module full of parameters initialized with sized literals of @a width bits,
+/// in each of the four bases. Decimal literals are kept within 32 bits, since
+/// that's all that sized decimal literals support.
+std::string generateWideLiteralSource(int literals, int width);
+
+/// Produces a module hierarchy @a depth levels deep in which each module
+/// instantiates @a fanout copies of the next level down. A top module holds
+/// @a tops copies of the first level, so the total number of instances is
+/// tops * (fanout^depth - 1) / (fanout - 1), plus one for the top itself.
+std::string generateHierarchySource(int tops, int depth, int fanout);
+
+/// Describes a set of generated include files.
+struct GeneratedIncludes {
+    /// Source text for the top level file, which includes all of the others.
+    std::string top;
+
+    /// Total size of all of the generated files, including the top one.
+    size_t totalBytes = 0;
+};
+
+/// Registers @a chains separate chains of include files, each @a depth files deep,
+/// as overlays in the given source manager. Every file includes the next one in its
+/// chain and adds some declarations of its own.
+GeneratedIncludes generateIncludeChains(SourceManager& sourceManager, int chains, int depth);
+
+/// Registers a header without an include guard as an overlay in the given source manager,
+/// and produces a top level file with @a modules modules that each include it, the way
+/// common declarations are often pulled into every module of a design.
+GeneratedIncludes generateRepeatedIncludes(SourceManager& sourceManager, int modules);
+
+} // namespace slang::bench
@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+// main.cpp
+// Entry point for the benchmark runner.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+#include "Benchmark.h"
+
+using namespace slang::bench;
+using json = nlohmann::json;
+
+// Usage: benchmarks [--min-time <seconds>] [--scale <factor>] [--json <file>] [filter...]
+// Only benchmarks whose names contain one of the filter strings are run.
+//
+// The JSON output follows the layout used by Google Benchmark, so results from
+// different releases can be compared with the usual tools for that format.
+int main(int argc, char** argv) {
+    double minSeconds = 1.0;
+    double scale = 1.0;
+    const char* jsonFile = nullptr;
+    std::vector<const char*> filters;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc)
+            minSeconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+            scale = atof(argv[++i]);
+        else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonFile = argv[++i];
+        else
+            filters.push_back(argv[i]);
+    }
+
+    char date[32];
+    time_t now = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    json results = json::array();
+
+    printf("%-40s %12s %14s %12s\n", "Benchmark", "Iterations", "Time/iter (us)", "MB/s");
+    for (auto& info : getBenchmarks()) {
+        if (!filters.empty()) {
+            bool matched = false;
+            for (auto filter : filters)
+                matched |= info.name.find(filter) != std::string::npos;
+            if (!matched)
+                continue;
+        }
+
+        State state(minSeconds, scale);
+        info.func(state);
+
+        double seconds = state.elapsedSeconds();
+        uint64_t iterations = state.iterations();
+        double perIter = iterations ? seconds * 1e6 / double(iterations) : 0.0;
+        double mbps = seconds > 0 ? double(state.bytesProcessed()) / (1024.0 * 1024.0) / seconds
+                                  : 0.0;
+
+        printf("%-40s %12llu %14.2f %12.2f\n", info.name.c_str(), (unsigned long long)iterations,
+               perIter, mbps);
+
+        for (auto& [name, value] : state.counters())
+            printf("    %s = %.2f\n", name.c_str(), value);
+
+        json result;
+        result["name"] = info.name;
+        result["run_name"] = info.name;
+        result["run_type"] = "iteration";
+        result["iterations"] = iterations;
+        result["real_time"] = perIter;
+        result["cpu_time"] = perIter;
+        result["time_unit"] = "us";
+        if (state.bytesProcessed())
+            result["bytes_per_second"] = double(state.bytesProcessed()) / seconds;
+        for (auto& [name, value] : state.counters())
+            result[name] = value;
+        results.push_back(std::move(result));
+    }
+
+    if (jsonFile) {
+        json output;
+        output["context"] = { { "date", date },
+                              { "executable", argv[0] },
+                              { "min_time", minSeconds },
+                              { "scale", scale } };
+        output["benchmarks"] = std::move(results);
+
+        std::ofstream file(jsonFile);
+        if (!file) {
+            fprintf(stderr, "error: could not open '%s' for writing\n", jsonFile);
+            return 1;
+        }
+        file << output.dump(2) << '\n';
+    }
+
+    return 0;
+}
@@ -57,6 +57,11 @@ public:
     /// global ones.
     const DefinitionSymbol* getDefinition(string_view name, const Scope& scope) const;
 
+    /// Gets the definition with the given interned name, or null if there is no such definition.
+    /// This takes into account the given scope so that nested definitions are found before more
+    /// global ones.
+    const DefinitionSymbol* getDefinition(IdentifierId name, const Scope& scope) const;
+
     /// Gets the top level definition with the given name, or null if there is no such definition.
     const DefinitionSymbol* getDefinition(string_view name) const;
 
@@ -66,6 +71,9 @@ public:
     /// Gets the package with the give name, or null if there is no such package.
     const PackageSymbol* getPackage(string_view name) const;
 
+    /// Gets the package with the given interned name, or null if there is no such package.
+    const PackageSymbol* getPackage(IdentifierId name) const;
+
     /// Adds a package to the map of global packages.
     void addPackage(const PackageSymbol& package);
 
@@ -164,6 +172,9 @@ public:
     /// Allocates a symbol map.
     SymbolMap* allocSymbolMap() { return symbolMapAllocator.emplace(); }
 
+    /// Allocates a port map.
+    PortMap* allocPortMap() { return portMapAllocator.emplace(); }
+
 private:
     // These functions are called by Scopes to create and track various members.
     friend class Scope;
@@ -192,6 +203,7 @@ private:
 
     // Specialized allocators for types that are not trivially destructible.
     TypedBumpAllocator<SymbolMap> symbolMapAllocator;
+    TypedBumpAllocator<PortMap> portMapAllocator;
     TypedBumpAllocator<ConstantValue> constantAllocator;
 
     // Sideband data for scopes that have deferred members.
@@ -204,13 +216,13 @@ private:
     // The name map for global definitions. The key is a combination of definition name +
     // the scope in which it was declared. The value is the definition symbol along with a
     // boolean that indicates whether it has ever been instantiated in the design.
-    mutable flat_hash_map<std::tuple<string_view, const Scope*>,
+    mutable flat_hash_map<std::tuple<IdentifierId, const Scope*>,
                           std::tuple<const DefinitionSymbol*, bool>>
         definitionMap;
 
     // The name map for packages. Note that packages have their own namespace,
     // which is why they can't share the definitions name table.
-    flat_hash_map<string_view, const PackageSymbol*> packageMap;
+    flat_hash_map<IdentifierId, const PackageSymbol*> packageMap;
 
     // The name map for system subroutines.
     flat_hash_map<string_view, std::unique_ptr<SystemSubroutine>> subroutineMap;
@@ -34,8 +34,23 @@ public:
 private:
     void addDigit(logic_t digit, int maxValue);
 
+    size_t appendPacked(string_view text);
+    void addPackedDigits(uint64_t value, uint32_t count);
+    uint64_t getPackedBits(size_t start, uint32_t count) const;
+    void unpack();
+    SVInt finishPacked();
+
     Diagnostics& diagnostics;
     SmallVectorSized<logic_t, 16> digits;
+
+    // For binary, octal, and hex literals, known digits are packed directly into
+    // a stream of bits (most significant first) instead of being added to the list
+    // of digits above. The first unknown digit moves everything over to that list.
+    SmallVectorSized<uint64_t, 4> packedWords;
+    size_t packedBits = 0;
+    uint32_t bitsPerDigit = 0;
+    bool packed = false;
+
     SourceLocation firstLocation;
     bitwidth_t sizeBits = 0;
     LiteralBase literalBase = LiteralBase::Binary;
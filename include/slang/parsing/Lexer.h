@@ -8,6 +8,7 @@
 
 #include "slang/diagnostics/Diagnostics.h"
 #include "slang/parsing/Token.h"
+#include "slang/parsing/TokenCache.h"
 #include "slang/text/SourceLocation.h"
 #include "slang/util/SmallVector.h"
 #include "slang/util/Util.h"
@@ -23,6 +24,26 @@ struct LexerOptions {
     /// The maximum number of errors that can occur before the rest of the source
     /// buffer is skipped.
     uint32_t maxErrors = 16;
+
+    /// If set to false, trivia is not faithfully recorded on tokens. Comments, whitespace
+    /// runs, and blank lines are collapsed so that each token carries at most a single
+    /// canonical space or newline, which avoids allocating trivia for nearly every token.
+    /// Only the trivia that directives and macros rely on is kept (line endings, comments
+    /// with line continuations, and multi-line block comments). This is useful for
+    /// pipelines that never need to print source text back out; printing such a tree
+    /// produces normalized text, and whitespace in stringified macro arguments is
+    /// likewise collapsed to single spaces.
+    bool preserveTrivia = true;
+
+    /// If set, lexers that start at the beginning of a source buffer look for the
+    /// buffer's tokens in the given cache and replay them instead of lexing the text.
+    /// Buffers that aren't in the cache yet are lexed normally and then added to it.
+    TokenCache* tokenCache = nullptr;
+
+    /// If set to false, lexers don't check up front whether their buffer is valid UTF-8.
+    /// The preprocessor turns this off for the lexers it creates, and instead checks each
+    /// file only once no matter how many times it gets included.
+    bool checkEncoding = true;
 };
 
 /// The Lexer is responsible for taking source text and chopping it up into tokens.
@@ -35,6 +56,7 @@ class Lexer {
 public:
     Lexer(SourceBuffer buffer, BumpAllocator& alloc, Diagnostics& diagnostics,
           LexerOptions options = LexerOptions{});
+    ~Lexer();
 
     // Not copyable
     Lexer(const Lexer&) = delete;
@@ -45,6 +67,17 @@ public:
     /// an infinite stream of EndOfFile tokens will be generated
     Token lex(KeywordVersion keywordVersion = getDefaultKeywordVersion());
 
+    /// Skips over the text of an inactive conditional compilation block without lexing it,
+    /// stopping just before the `else, `elsif, or `endif that ends the block, or at the end
+    /// of the buffer. Nested conditional blocks are skipped entirely. Comments and string
+    /// literals are recognized so that directives within them aren't mistaken for real ones,
+    /// but no other tokens are formed and no diagnostics are issued.
+    ///
+    /// On success, @a text is set to the skipped text and @a location to its start. Returns
+    /// false without doing anything if the lexer needs to see every token, which is the
+    /// case when a token cache is in use.
+    bool skipDisabledText(string_view& text, SourceLocation& location);
+
     BufferID getBufferID() const;
     BumpAllocator& getAllocator() { return alloc; }
     Diagnostics& getDiagnostics() { return diagnostics; }
@@ -81,6 +114,7 @@ private:
     bool lexTimeLiteral(Token::Info* info);
 
     void lexTrivia(SmallVector<Trivia>& triviaBuffer);
+    span<Trivia const> discardTrivia(const SmallVector<Trivia>& triviaBuffer);
 
     void scanBlockComment(SmallVector<Trivia>& triviaBuffer);
     void scanLineComment(SmallVector<Trivia>& triviaBuffer);
@@ -89,6 +123,10 @@ private:
     void scanUnsignedNumber(uint64_t& value, int& digits);
     bool scanExponent(uint64_t& value, bool& negative);
 
+    void checkEncoding();
+    bool lexCached(KeywordVersion keywordVersion, Token& result);
+    void recordCached(Token token, KeywordVersion keywordVersion);
+
     void addTrivia(TriviaKind kind, SmallVector<Trivia>& triviaBuffer);
     void addDiag(DiagCode code, uint32_t offset);
 
@@ -134,6 +172,12 @@ private:
     // Keeps track of whether we just entered a new line, to enforce tokens
     // that must start on their own line
     bool onNewLine = true;
+
+    // State for replaying or recording tokens when a token cache is in use.
+    const TokenCache::Entry* cachedTokens = nullptr;
+    TokenCache::Recorder* cacheRecorder = nullptr;
+    uint32_t cacheIndex = 0;
+    bool cacheChecked = false;
 };
 
 } // namespace slang
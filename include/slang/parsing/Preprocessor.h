@@ -6,8 +6,8 @@
 //------------------------------------------------------------------------------
 #pragma once
 
-#include <deque>
-#include <unordered_map>
+#include <flat_hash_map.hpp>
+#include <memory>
 
 #include "slang/diagnostics/Diagnostics.h"
 #include "slang/parsing/Lexer.h"
@@ -25,6 +25,7 @@ struct MacroActualArgumentListSyntax;
 struct MacroFormalArgumentListSyntax;
 struct MacroActualArgumentSyntax;
 struct MacroFormalArgumentSyntax;
+class PreprocessorSnapshot;
 
 string_view getDirectiveText(SyntaxKind kind);
 
@@ -34,6 +35,11 @@ struct PreprocessorOptions {
     /// a file will result in an error.
     uint32_t maxIncludeDepth = 1024;
 
+    /// If set, the preprocessor starts out with the macros and directive state captured
+    /// in the given snapshot, as if it had processed the same text that the snapshot's
+    /// preprocessor did. The @a predefines and @a undefines options are applied on top.
+    const PreprocessorSnapshot* snapshot = nullptr;
+
     /// The name to associate with errors produced by macros specified
     /// via the @a predefines option.
     std::string predefineSource = "<api>";
@@ -44,6 +50,14 @@ struct PreprocessorOptions {
 
     /// A set of macro names to undefine at the start of file preprocessing.
     std::vector<std::string> undefines;
+
+    /// If set, included files are lexed with the given token cache (unless a cache is
+    /// already set in the LexerOptions, which then applies to all files). Including a
+    /// file whose tokens are already in the cache replays them under the new buffer
+    /// instead of lexing the text again. Preprocessors for different syntax trees can
+    /// share a cache, which is typically created to live in memory only. Note that
+    /// inactive conditional branches in cached files are lexed token by token.
+    TokenCache* includeTokenCache = nullptr;
 };
 
 /// Preprocessor - Interface between lexer and parser
@@ -55,6 +69,10 @@ class Preprocessor {
 public:
     Preprocessor(SourceManager& sourceManager, BumpAllocator& alloc, Diagnostics& diagnostics,
                  const Bag& options = {});
+    ~Preprocessor();
+
+    Preprocessor(const Preprocessor&) = delete;
+    Preprocessor& operator=(const Preprocessor&) = delete;
 
     /// Push a new source file onto the stack.
     void pushSource(string_view source);
@@ -99,11 +117,25 @@ public:
     /// Gets the next token in the stream, after applying preprocessor rules.
     Token next();
 
+    /// Gets all of the source buffers that have been pushed onto the preprocessor,
+    /// either directly or via include directives, in the order they were pushed.
+    /// If the preprocessor was started from a snapshot, the buffers the snapshot's
+    /// macros came from are listed first, since expanded tokens can point into them.
+    span<const BufferID> getSourceBuffers() const { return sourceBuffers; }
+
+    /// Captures the currently defined macros and the state of other compiler directives,
+    /// so that other preprocessors can start from this point without processing the
+    /// same text again. This is typically done after running through a prelude of
+    /// common definitions, similar to a precompiled header.
+    PreprocessorSnapshot snapshot() const;
+
     SourceManager& getSourceManager() const { return sourceManager; }
     BumpAllocator& getAllocator() const { return alloc; }
     Diagnostics& getDiagnostics() const { return diagnostics; }
 
 private:
+    friend class PreprocessorSnapshot;
+
     // Internal methods to grab and handle the next token
     Token nextProcessed();
     Token nextRaw();
@@ -128,10 +160,17 @@ private:
     Trivia createSimpleDirective(Token directive);
 
     // Determines whether the else branch of a conditional directive should be taken
-    bool shouldTakeElseBranch(SourceLocation location, bool isElseIf, string_view macroName);
+    bool shouldTakeElseBranch(SourceLocation location, bool isElseIf, IdentifierId macroName);
 
     // Handle parsing a branch of a conditional directive
     Trivia parseBranchDirective(Token directive, Token condition, bool taken);
+    bool skipDisabledText();
+
+    // Pull tokens from and pop the innermost source file, keeping track of include guards
+    Token lexSource();
+    void pushSource(SourceBuffer buffer, LexerOptions options);
+    void popSource();
+    void checkIncludeGuardBranch(bool isEndIf);
 
     // Timescale specifier parser
     bool expectTimescaleSpecifier(Token& value, Token& unit, TimescaleMagnitude& magnitude);
@@ -154,6 +193,21 @@ private:
         bool needsArgs() const;
     };
 
+    using MacroMap = flat_hash_map<IdentifierId, MacroDef>;
+
+    // Keeps the text of the buffers that a snapshot's macros were read from in memory.
+    // Shared by all copies of the snapshot and all preprocessors started from them.
+    struct RetainedText {
+        SourceManager& sourceManager;
+        std::vector<BufferID> buffers;
+
+        RetainedText(SourceManager& sourceManager, std::vector<BufferID> buffers);
+        ~RetainedText();
+
+        RetainedText(const RetainedText&) = delete;
+        RetainedText& operator=(const RetainedText&) = delete;
+    };
+
     // Helper class for tracking state used during expansion of a macro.
     class MacroExpansion {
     public:
@@ -174,8 +228,68 @@ private:
         bool isTopLevel = false;
     };
 
+    // A location referenced by a memoized macro expansion. It's either a fixed location,
+    // such as one in a macro definition, or an offset into one of the expansion locations
+    // that get created anew each time the memoized expansion is replayed.
+    struct MemoLocation {
+        static constexpr uint32_t Fixed = UINT32_MAX;
+
+        SourceLocation location;
+        uint32_t expansion = Fixed;
+        uint32_t offset = 0;
+    };
+
+    // An expansion location that needs to be recreated when replaying a memoized expansion.
+    // The first one is always the expansion of the macro itself, whose range is taken from
+    // the usage site being replayed.
+    struct MemoExpansionLoc {
+        MemoLocation original;
+        MemoLocation start;
+        MemoLocation end;
+        string_view macroName;
+        bool isMacroArg;
+    };
+
+    // The fully expanded tokens of an object-like macro. Expanding such a macro always gives
+    // the same tokens as long as the macros it refers to are defined the same way, so later
+    // usages only need to recreate the expansion locations and relocate the tokens.
+    struct MacroMemo {
+        span<const MemoExpansionLoc> expansions;
+        span<const Token> tokens;
+        span<const MemoLocation> locations;
+
+        // Every macro looked up during the expansion, with the definition that was found,
+        // if any. The memo is stale once any of them has been defined or undefined.
+        span<const std::pair<IdentifierId, DefineDirectiveSyntax*>> dependencies;
+        KeywordVersion keywordVersion;
+    };
+
+    // Tracks what happens during a macro expansion so that it can be memoized.
+    struct MemoRecorder {
+        struct ExpansionLoc {
+            SourceLocation result;
+            SourceLocation original;
+            SourceLocation start;
+            SourceLocation end;
+            string_view macroName;
+            bool isMacroArg;
+        };
+
+        SmallVectorSized<ExpansionLoc, 8> expansions;
+        SmallVectorSized<std::pair<IdentifierId, DefineDirectiveSyntax*>, 8> dependencies;
+        bool usedIntrinsic = false;
+
+        // Set if a nested macro pulled its arguments from the source text following the
+        // usage site, in which case the expansion isn't determined by the definitions alone.
+        bool usedSourceTokens = false;
+    };
+
     // Macro handling methods
     MacroDef findMacro(Token directive);
+    SourceLocation createExpansionLoc(SourceLocation originalLoc, SourceLocation start,
+                                      SourceLocation end, string_view macroName, bool isMacroArg);
+    bool replayMemo(const MacroMemo& memo, Token directive);
+    void storeMemo(DefineDirectiveSyntax* macro, const MemoRecorder& recorder);
     MacroActualArgumentListSyntax* handleTopLevelMacro(Token directive);
     bool expandMacro(MacroDef macro, MacroExpansion& expansion,
                      MacroActualArgumentListSyntax* actualArgs);
@@ -209,6 +323,26 @@ private:
         BranchEntry(bool taken) : anyTaken(taken), currentActive(taken) {}
     };
 
+    // Keeps track of whether a source file has an include guard, which is the case
+    // if everything in it is inside a single `ifndef block without any `else or
+    // `elsif. Once such a file has been seen, later includes of it can be skipped
+    // entirely as long as the guard macro is still defined.
+    struct IncludeGuardEntry {
+        enum class State { Start, ExpectMacro, InGuard, AfterEndIf, NotGuarded };
+
+        // The text of the file, which identifies it regardless of the path used to include it.
+        const char* text;
+
+        // How far along the file is in matching the include guard pattern.
+        State state = State::Start;
+
+        // The name of the guard macro, and the depth of the branch stack inside its block.
+        IdentifierId macro = IdentifierId::Invalid;
+        size_t branchDepth = 0;
+
+        IncludeGuardEntry(const char* text) : text(text) {}
+    };
+
     // Helper class for parsing macro arguments. There's a lot of otherwise overlapping code that
     // this class consolidates, but it makes it a little confusing. If a buffer is provided via
     // setBuffer(), tokens are pulled from there first. Otherwise it just pulls from the main
@@ -242,6 +376,9 @@ private:
         Token expect(TokenKind kind);
         bool peek(TokenKind kind) { return peek().kind == kind; }
 
+        // Notes that tokens are being taken from the underlying preprocessor stream.
+        void markSourceTokensUsed();
+
         Preprocessor& pp;
         span<Token const> buffer;
         uint32_t currentIndex = 0;
@@ -252,15 +389,39 @@ private:
     Diagnostics& diagnostics;
     PreprocessorOptions options;
     LexerOptions lexerOptions;
+    LexerOptions includeLexerOptions;
 
     // stack of active lexers; each `include pushes a new lexer
-    std::deque<Lexer*> lexerStack;
+    SmallVectorSized<Lexer*, 8> lexerStack;
+
+    // all buffers that have ever been pushed onto the lexer stack, preceded by
+    // the buffers of the snapshot we started from (if any)
+    std::vector<BufferID> sourceBuffers;
+
+    // keeps the text of the snapshot we started from alive, since expanding its
+    // macros produces tokens that point into it
+    std::shared_ptr<const RetainedText> snapshotText;
 
     // keep track of nested processor branches (ifdef, ifndef, else, elsif, endif)
-    std::deque<BranchEntry> branchStack;
+    SmallVectorSized<BranchEntry, 8> branchStack;
+
+    // include guard detection state for each entry in the lexer stack
+    SmallVectorSized<IncludeGuardEntry, 8> includeGuardStack;
 
-    // map from macro name to macro definition
-    std::unordered_map<string_view, MacroDef> macros;
+    // map from the text of files known to have include guards to their guard macros
+    flat_hash_map<const char*, IdentifierId> includeGuards;
+
+    // the text of files whose encoding has already been checked
+    flat_hash_set<const char*> encodingChecked;
+
+    // map from interned macro name to macro definition
+    MacroMap macros;
+
+    // memoized expansions of object-like macros, keyed by their definitions
+    flat_hash_map<const DefineDirectiveSyntax*, MacroMemo> macroMemos;
+
+    // set while expanding a top level macro whose expansion is being memoized
+    MemoRecorder* memoRecorder = nullptr;
 
     // list of expanded macro tokens to drain before continuing with active lexer
     SmallVectorSized<Token, 16> expandedTokens;
@@ -280,10 +441,52 @@ private:
     // A buffer used to hold tokens while we're busy consuming them for directives.
     SmallVectorSized<Token, 16> scratchTokenBuffer;
 
+    // Inactive conditional text that was skipped without being lexed; it gets attached
+    // as trivia after the directive that started it.
+    SmallVectorSized<Trivia, 2> disabledText;
+
     /// Various state set by preprocessor directives.
     std::vector<KeywordVersion> keywordVersionStack;
     optional<Timescale> activeTimescale;
     TokenKind defaultNetType;
 };
 
+/// PreprocessorSnapshot - The macros and compiler directive state of a Preprocessor
+/// at some point in time, created by Preprocessor::snapshot. New preprocessors can
+/// start from a snapshot via PreprocessorOptions::snapshot.
+///
+/// Macro definitions in the snapshot refer to syntax nodes owned by the allocator of
+/// the preprocessor that created it, and to source buffers in its source manager.
+/// The snapshot can only be used with that same source manager, and the allocator
+/// must outlive all preprocessors and syntax trees that use the snapshot. The text of
+/// those buffers is retained (see SourceManager::retainText) for as long as any copy
+/// of the snapshot, or any preprocessor started from it, is alive; syntax trees built
+/// by such preprocessors retain it as well. None of these may outlive the source manager.
+class PreprocessorSnapshot {
+public:
+    /// Checks whether the given macro was defined when the snapshot was taken.
+    bool isDefined(string_view name) const;
+
+    /// Gets the number of macros in the snapshot, not including intrinsic macros.
+    size_t getMacroCount() const;
+
+    /// Gets the keyword version that was in effect when the snapshot was taken.
+    KeywordVersion getKeywordVersion() const { return keywordVersionStack.back(); }
+
+    /// Gets the timescale that was active when the snapshot was taken, if any.
+    const optional<Timescale>& getTimescale() const { return timescale; }
+
+    /// Gets the default net type that was active when the snapshot was taken.
+    TokenKind getDefaultNetType() const { return defaultNetType; }
+
+private:
+    friend class Preprocessor;
+
+    std::shared_ptr<const Preprocessor::RetainedText> retainedText;
+    Preprocessor::MacroMap macros;
+    std::vector<KeywordVersion> keywordVersionStack;
+    optional<Timescale> timescale;
+    TokenKind defaultNetType = TokenKind::WireKeyword;
+};
+
 } // namespace slang
@@ -9,6 +9,7 @@
 #include "slang/numeric/SVInt.h"
 #include "slang/numeric/Time.h"
 #include "slang/text/SourceLocation.h"
+#include "slang/util/IdentifierTable.h"
 #include "slang/util/SmallVector.h"
 #include "slang/util/StringTable.h"
 #include "slang/util/Util.h"
@@ -127,47 +128,78 @@ static_assert(sizeof(Trivia) == 16);
 class Token {
 public:
     /// Heap-allocated info block.
+    ///
+    /// Every token gets one of these, so it's kept small: the trivia and raw text spans
+    /// are stored as pointer and length pairs, and kind-specific data lives in a single
+    /// word. Integer literal values are the only payload that doesn't fit in that word,
+    /// so they are allocated out of line.
     struct Info {
-        /// Numeric-related information.
-        struct NumericLiteralInfo {
-            std::variant<logic_t, double, SVIntStorage> value;
-            NumericTokenFlags numericFlags;
-        };
+        /// Extra kind-specific data associated with the token. Which member is active
+        /// is determined by the kind of the owning token.
+        union Extra {
+            /// The value of an integer literal.
+            const SVIntStorage* integer;
 
-        /// Leading trivia.
-        span<slang::Trivia const> trivia;
+            /// The value of a real or time literal.
+            double real;
 
-        /// The raw source span.
-        string_view rawText;
+            /// The value of an unbased unsized literal.
+            uint8_t bit;
+
+            /// The kind of a directive token.
+            SyntaxKind directiveKind;
+
+            /// The kind of an identifier token.
+            IdentifierType idType;
+
+            /// The nice text of a string literal; null if empty.
+            const string_view* stringText;
+        };
 
         /// The original location in the source text (or a macro location
         /// if the token was generated during macro expansion).
         SourceLocation location;
 
-        /// Extra kind-specific data associated with the token.
-        /// string_view: The nice text of a string literal.
-        /// SyntaxKind: The kind of a directive token.
-        /// IdentifierType: The kind of an identifer token.
-        /// NumericLiteralInfo: Info for numeric tokens.
-        std::variant<string_view, SyntaxKind, IdentifierType, NumericLiteralInfo> extra;
+        Extra extra{};
 
         /// Various token flags.
         bitmask<TokenFlags> flags;
 
+        /// Base, signedness, and time unit for numeric tokens.
+        NumericTokenFlags numFlags;
+
+        /// The interned name of an identifier or macro usage token, if known.
+        /// This fits in what would otherwise be padding, so it costs no space.
+        IdentifierId identifierId = IdentifierId::Invalid;
+
         Info() = default;
         Info(span<Trivia const> trivia, string_view rawText, SourceLocation location,
              bitmask<TokenFlags> flags = TokenFlags::None);
 
-        void setBit(logic_t value);
-        void setReal(double value);
-        void setInt(BumpAllocator& alloc, const SVInt& value);
-        void setNumFlags(LiteralBase base, bool isSigned);
-        void setTimeUnit(TimeUnit unit);
+        /// Leading trivia.
+        span<Trivia const> trivia() const { return { triviaPtr, triviaCount }; }
+        void setTrivia(span<Trivia const> trivia);
 
-        const string_view& stringText() const { return std::get<string_view>(extra); }
-        const SyntaxKind& directiveKind() const { return std::get<SyntaxKind>(extra); }
-        const IdentifierType& idType() const { return std::get<IdentifierType>(extra); }
-        const NumericLiteralInfo& numInfo() const { return std::get<NumericLiteralInfo>(extra); }
+        /// The raw source span.
+        string_view rawText() const { return { rawTextPtr, rawTextLength }; }
+        void setRawText(string_view text);
+
+        void setBit(logic_t value) { extra.bit = value.value; }
+        void setReal(double value) { extra.real = value; }
+        void setInt(BumpAllocator& alloc, const SVInt& value);
+        void setNumFlags(LiteralBase base, bool isSigned) { numFlags.set(base, isSigned); }
+        void setTimeUnit(TimeUnit unit) { numFlags.set(unit); }
+        void setStringText(BumpAllocator& alloc, string_view text);
+
+        string_view stringText() const {
+            return extra.stringText ? *extra.stringText : string_view();
+        }
+
+    private:
+        const Trivia* triviaPtr = nullptr;
+        const char* rawTextPtr = nullptr;
+        uint32_t triviaCount = 0;
+        uint32_t rawTextLength = 0;
     };
 
     /// The kind of the token; this is not in the info block because
@@ -182,7 +214,7 @@ public:
 
     SourceRange range() const;
     SourceLocation location() const { return info->location; }
-    span<Trivia const> trivia() const { return info->trivia; }
+    span<Trivia const> trivia() const { return info->trivia(); }
     const Info* getInfo() const { return info; }
 
     /// Value text is the "nice" lexed version of certain tokens;
@@ -202,6 +234,12 @@ public:
     logic_t bitValue() const;
     NumericTokenFlags numericFlags() const;
     IdentifierType identifierType() const;
+
+    /// Gets the interned ID of an identifier's value text. Macro usage directives are
+    /// interned by the name of the macro, without the leading backtick. Other kinds of
+    /// tokens return IdentifierId::Invalid. This is a pure lookup; names that were
+    /// never interned also return IdentifierId::Invalid.
+    IdentifierId identifierId() const;
     SyntaxKind directiveKind() const;
 
     bool valid() const { return info != nullptr; }
@@ -218,10 +256,11 @@ public:
 private:
     const Info* info;
 };
+static_assert(sizeof(Token::Info) == 48);
 
 /// Different restricted sets of keywords that can be set using the
 /// `begin_keywords directive. The values of the enum correspond to indexes to
-/// allKeywords[] in LexerFacts.cpp
+/// the generated allKeywords[] table.
 enum class KeywordVersion : uint8_t {
     v1364_1995 = 0,
     v1364_2001_noconfig = 1,
@@ -0,0 +1,108 @@
+//------------------------------------------------------------------------------
+// TokenCache.h
+// Cache of lexed token streams.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "slang/parsing/Token.h"
+#include "slang/util/Util.h"
+
+namespace slang {
+
+class BumpAllocator;
+
+/// TokenCache - stores the tokens produced by lexing whole source files, so that
+/// files that have been lexed before can replay them instead of lexing the text again.
+/// Entries are kept in memory, and optionally on disk so that later runs over files
+/// that haven't changed can use them as well.
+///
+/// Entries are keyed on a hash of the file contents together with the lexer options
+/// that affect its output and the keyword version in effect at the start of the file.
+/// Each entry records the kind, location, and value of every token along with the
+/// ranges of its trivia; the text itself always comes from the source buffer being
+/// lexed. The on-disk format uses offsets rather than pointers and is memory mapped
+/// when it is read back where the platform supports it.
+///
+/// Only files that lex without any diagnostics are cached. Files that contain an integer
+/// literal with unknown (x or z) digits, or one that's wider than 64 bits, aren't cached
+/// either, since the cache only has room for a single word of integer value per token;
+/// such files are lexed normally every time.
+///
+/// If the keyword version changes partway through a file (via a `begin_keywords
+/// directive, for example) in a way that doesn't match the cached entry, the lexer
+/// stops replaying at that point and lexes the rest of the file from scratch.
+///
+/// To use the cache, set LexerOptions::tokenCache. The cache must outlive all lexers
+/// that use it, but tokens that were replayed from it don't refer to its memory.
+/// All methods are thread safe.
+class TokenCache {
+public:
+    /// Creates a cache that only keeps its entries in memory. This is useful for sharing
+    /// the tokens of files that are lexed many times in a single run, such as headers
+    /// that get included over and over (see PreprocessorOptions::includeTokenCache).
+    TokenCache();
+
+    /// Creates a cache that stores its entries in the given directory, which is created
+    /// if it doesn't exist. Problems reading or writing cache files are not reported;
+    /// affected files are simply lexed normally.
+    explicit TokenCache(string_view directory);
+    ~TokenCache();
+
+    TokenCache(const TokenCache&) = delete;
+    TokenCache& operator=(const TokenCache&) = delete;
+
+    /// The version of the on-disk format. This must be incremented whenever the format
+    /// or the lexer's output changes, which invalidates all existing cache files.
+    static constexpr uint32_t FormatVersion = 2;
+
+    /// Gets the number of lexers that replayed cached tokens.
+    size_t getHitCount() const;
+
+    /// Gets the number of lexers that found nothing in the cache and lexed from scratch.
+    size_t getMissCount() const;
+
+    /// Gets the number of files whose tokens are currently being recorded. Recordings are
+    /// committed when a lexer reaches the end of its file, and dropped if it's destroyed first.
+    size_t getRecordingCount() const;
+
+private:
+    friend class Lexer;
+
+    struct Entry;
+    struct Recorder;
+
+    // Called by the lexer before it lexes the first token of a file. Returns the entry
+    // to replay for the given text, or nullptr if there isn't one; in that case a new
+    // recorder is returned in @a recorder, which the lexer should feed all of its tokens.
+    const Entry* lookup(string_view source, bool preserveTrivia, KeywordVersion keywordVersion,
+                        Recorder*& recorder);
+
+    // Recreates the token at @a index of a cached entry. Returns false if the keyword
+    // version doesn't match the one the token was lexed with, in which case @a resumeOffset
+    // is set to where the lexer should pick up lexing the text again.
+    static bool replay(const Entry& entry, uint32_t index, KeywordVersion keywordVersion,
+                       BufferID bufferId, const char* source, BumpAllocator& alloc, Token& result,
+                       uint32_t& resumeOffset);
+
+    // Adds a newly lexed token to a recorder. Once the end of the file is reached the
+    // recorder is committed to the cache. Returns false if the recorder has been committed
+    // or discarded (because the token couldn't be cached), after which it must not be used.
+    bool record(Recorder& recorder, Token token, KeywordVersion keywordVersion);
+    void discard(Recorder& recorder);
+    void writeEntry(uint64_t key, const char* data, size_t size);
+
+    std::string directory;
+    std::unordered_map<uint64_t, std::unique_ptr<Entry>> entries;
+    std::unordered_map<Recorder*, std::unique_ptr<Recorder>> recorders;
+    size_t hits = 0;
+    size_t misses = 0;
+    mutable std::mutex mut;
+};
+
+} // namespace slang
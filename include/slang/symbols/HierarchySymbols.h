@@ -56,7 +56,7 @@ public:
     DefinitionSymbol(Compilation& compilation, string_view name, SourceLocation loc,
                      DefinitionKind definitionKind, const NetType& defaultNetType);
 
-    const SymbolMap& getPortMap() const {
+    const PortMap& getPortMap() const {
         ensureElaborated();
         return *portMap;
     }
@@ -72,7 +72,7 @@ public:
     static bool isKind(SymbolKind kind) { return kind == SymbolKind::Definition; }
 
 private:
-    SymbolMap* portMap;
+    PortMap* portMap;
 };
 
 /// Base class for module, interface, and program instance symbols.
@@ -80,7 +80,7 @@ class InstanceSymbol : public Symbol, public Scope {
 public:
     const DefinitionSymbol& definition;
 
-    const SymbolMap& getPortMap() const {
+    const PortMap& getPortMap() const {
         ensureElaborated();
         return *portMap;
     }
@@ -101,7 +101,7 @@ protected:
                   span<const Expression* const> parameterOverrides);
 
 private:
-    SymbolMap* portMap;
+    PortMap* portMap;
 };
 
 class ModuleInstanceSymbol : public InstanceSymbol {
@@ -23,7 +23,12 @@ class StatementBodiedScope;
 class SystemSubroutine;
 class WildcardImportSymbol;
 
-using SymbolMap = flat_hash_map<string_view, const Symbol*>;
+/// Maps member names to symbols. Names are interned, so lookups hash and compare
+/// a single integer instead of the full text of the name.
+using SymbolMap = flat_hash_map<IdentifierId, const Symbol*>;
+
+/// Maps port names to port symbols.
+using PortMap = flat_hash_map<string_view, const Symbol*>;
 
 /// Additional modifiers for a lookup operation.
 enum class LookupFlags {
@@ -144,6 +149,10 @@ public:
     /// members. If no symbol is found with the given name, nullptr is returned.
     const Symbol* find(string_view name) const;
 
+    /// Finds a direct child member with the given interned name. This behaves the same as
+    /// the overload that takes a string, but avoids interning the name again.
+    const Symbol* find(IdentifierId name) const;
+
     /// Finds a direct child member with the given name. This won't return anything weird like
     /// forwarding typedefs or imported symbols, but will return things like transparent enum
     /// members. This method expects that the symbol will be found and be of the given type `T`.
@@ -365,8 +374,9 @@ private:
 
     // Performs an unqualified lookup in this scope, then recursively up the parent
     // chain until we reach root or the symbol is found.
-    void lookupUnqualifiedImpl(string_view name, LookupLocation location, SourceRange sourceRange,
-                               bitmask<LookupFlags> flags, LookupResult& result) const;
+    void lookupUnqualifiedImpl(string_view name, IdentifierId nameId, LookupLocation location,
+                               SourceRange sourceRange, bitmask<LookupFlags> flags,
+                               LookupResult& result) const;
 
     // Performs a qualified lookup in this scope using all of the various language rules for name
     // resolution.
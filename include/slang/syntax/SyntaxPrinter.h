@@ -16,6 +16,10 @@ class SyntaxTree;
 
 /// Provides support for printing tokens, trivia, or whole syntax trees
 /// back to source code.
+///
+/// Trees that were parsed with LexerOptions::preserveTrivia turned off can still be
+/// printed, but since their trivia was collapsed while lexing the output will have
+/// normalized whitespace and will be missing most comments.
 class SyntaxPrinter {
 public:
     SyntaxPrinter() = default;
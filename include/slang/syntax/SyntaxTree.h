@@ -7,6 +7,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include "slang/diagnostics/Diagnostics.h"
 #include "slang/parsing/Parser.h"
@@ -30,6 +31,7 @@ public:
 
     SyntaxTree(SyntaxTree&& other) = default;
     SyntaxTree& operator=(SyntaxTree&&) = default;
+    ~SyntaxTree();
 
     /// Creates a syntax tree from a full compilation unit.
     static std::shared_ptr<SyntaxTree> fromFile(string_view path);
@@ -47,6 +49,17 @@ public:
                                                   SourceManager& sourceManager,
                                                   const Bag& options = {});
 
+    /// Creates a syntax tree for each of the given buffers, which are all treated as
+    /// independent compilation units. The buffers are preprocessed and parsed in parallel
+    /// using up to @a threadCount threads; if @a threadCount is zero, the number of hardware
+    /// threads is used. The resulting trees are returned in the same order as the input
+    /// buffers, each holding its own diagnostics. If parsing any of the buffers throws an
+    /// exception, it is rethrown after all of the other buffers have finished.
+    static std::vector<std::shared_ptr<SyntaxTree>> fromBuffers(span<const SourceBuffer> buffers,
+                                                                SourceManager& sourceManager,
+                                                                const Bag& options = {},
+                                                                uint32_t threadCount = 0);
+
     /// Gets any diagnostics generated while parsing.
     Diagnostics& diagnostics() { return diagnosticsBuffer; }
 
@@ -88,7 +101,7 @@ public:
 private:
     SyntaxTree(SyntaxNode* root, SourceManager& sourceManager, BumpAllocator&& alloc,
                Diagnostics&& diagnostics, Parser::MetadataMap&& metadataMap, Bag options,
-               Token eof);
+               Token eof, span<const BufferID> sourceBuffers);
 
     static std::shared_ptr<SyntaxTree> create(SourceManager& sourceManager, SourceBuffer source,
                                               const Bag& options, bool guess);
@@ -101,6 +114,10 @@ private:
     Bag options_;
     std::shared_ptr<SyntaxTree> parentTree;
     Token eof;
+
+    // Source buffers whose text is retained in the source manager on our behalf,
+    // since all of our tokens point directly into that text.
+    std::vector<BufferID> retainedBuffers;
 };
 
 } // namespace slang
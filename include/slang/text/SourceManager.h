@@ -6,13 +6,20 @@
 //------------------------------------------------------------------------------
 #pragma once
 
+#include <atomic>
 #include <deque>
 #include <filesystem>
 #include <memory>
+#include <mutex>
 #include <set>
+#include <shared_mutex>
+#include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "slang/text/SourceLocation.h"
+#include "slang/util/AppendOnlyVector.h"
+#include "slang/util/BumpAllocator.h"
 #include "slang/util/Util.h"
 
 namespace fs = std::filesystem;
@@ -29,19 +36,41 @@ struct SourceBuffer {
     explicit operator bool() const { return id.valid(); }
 };
 
+/// Contains various options that can control source loading behavior.
+struct SourceManagerOptions {
+    /// If set to true, files loaded from disk are memory mapped instead of being
+    /// copied into heap allocated buffers. This avoids duplicating file contents that
+    /// are already in the OS page cache and reduces peak memory usage for large designs.
+    /// Note that files must not be truncated while the source manager is alive.
+    /// Platforms that don't support memory mapping silently fall back to normal reads.
+    bool memoryMapFiles = false;
+
+    /// If set to true, files loaded from disk are hashed and compared against all
+    /// other loaded files, and files with identical contents share a single copy of
+    /// the text and its line offset table. This is useful for designs that contain
+    /// many copies of the same headers at different paths.
+    bool deduplicateContents = false;
+};
+
 /// SourceManager - Handles loading and tracking source files.
 ///
 /// The source manager abstracts away the differences between
 /// locations in files and locations generated by macro expansion.
 /// See SourceLocation for more details.
 ///
-/// TODO: The methods in this class should be thread safe.
+/// All methods on this class are thread safe, so multiple files can be loaded and
+/// preprocessed concurrently. Queries about existing buffers (line and column numbers,
+/// expansion locations, etc) never block, even while other threads are adding buffers.
+/// Include directories should be added before any concurrent use begins.
 class SourceManager {
 public:
-    SourceManager();
+    explicit SourceManager(SourceManagerOptions options = {});
     SourceManager(const SourceManager&) = delete;
     SourceManager& operator=(const SourceManager&) = delete;
 
+    /// Gets the options that control how this source manager loads files.
+    const SourceManagerOptions& getOptions() const { return options; }
+
     /// Convert the given relative path into an absolute path.
     std::string makeAbsolutePath(string_view path) const;
 
@@ -110,9 +139,42 @@ public:
     /// file expansion location. Otherwise just returns the location itself.
     SourceLocation getFullyExpandedLoc(SourceLocation location) const;
 
-    /// Gets the actual source text for a given file buffer.
+    /// Gets the actual source text for a given file buffer. If the text was
+    /// released by releaseUnusedText, it is reloaded from disk.
     string_view getSourceText(BufferID buffer) const;
 
+    /// Checks whether the text of the given file buffer is valid UTF-8. The check is done
+    /// once per file and the result is cached, so it's cheap to ask again for files that
+    /// are included many times.
+    /// @return the offset of the first ill-formed sequence, or nullopt if there are none.
+    optional<uint32_t> getInvalidEncodingOffset(BufferID buffer) const;
+
+    /// Finds the first ill-formed UTF-8 sequence in the given null terminated text.
+    /// @return the offset of the sequence, or nullopt if the text is valid UTF-8.
+    static optional<uint32_t> findInvalidEncoding(string_view text);
+
+    /// Marks the text of the file backing the given buffer as being in use, so that
+    /// releaseUnusedText won't drop it. Each call must be balanced by a call to releaseText.
+    /// Syntax trees do this automatically for every file they were parsed from, since
+    /// their tokens point directly into the source text.
+    void retainText(BufferID buffer);
+
+    /// Releases a use of file text previously marked via retainText.
+    void releaseText(BufferID buffer);
+
+    /// Drops the text of files loaded from disk that aren't currently retained, until
+    /// the total size of file text held in memory is no more than @a budget bytes.
+    /// Line offsets are kept, and the text of dropped files is transparently reloaded
+    /// if it's needed again later (for example, to render a diagnostic). If a file's
+    /// contents change on disk in the meantime, the reloaded text is blanked out.
+    /// Overlay versions that have been replaced or removed are released first; their
+    /// text can't be reloaded, so it also reads back as blank.
+    ///
+    /// Any previously obtained views of the dropped text become invalid, so this must
+    /// not be called while other threads are loading or parsing files.
+    /// @return the number of bytes released.
+    size_t releaseUnusedText(size_t budget = 0);
+
     /// Creates a macro expansion location; used by the preprocessor.
     SourceLocation createExpansionLoc(SourceLocation originalLoc, SourceLocation expansionStart,
                                       SourceLocation expansionEnd, bool isMacroArg);
@@ -134,10 +196,30 @@ public:
     SourceBuffer assignBuffer(string_view path, std::vector<char>&& buffer,
                               SourceLocation includedFrom = SourceLocation());
 
+    /// Shadows the file at @a path with the given in-memory text. Subsequent attempts
+    /// to load the file, either directly or via an include directive, will see the
+    /// overlay contents instead of whatever is on disk (the file doesn't need to exist).
+    /// Setting an overlay for a path that already has one replaces it with a new version;
+    /// buffers previously handed out for older versions remain valid. Once nothing retains
+    /// the text of an older version, releaseUnusedText can drop it for good; see there.
+    /// @return the version number of the new contents, starting at 1.
+    uint32_t setOverlay(string_view path, string_view text);
+
+    /// Removes any in-memory overlay for the file at @a path, so that subsequent
+    /// loads of the file go back to reading it from disk.
+    void removeOverlay(string_view path);
+
+    /// Gets the version of the contents of the given file buffer. Files loaded from disk
+    /// and text assigned directly are version 0; overlays start at version 1 and are
+    /// incremented each time the overlay for a path is replaced.
+    uint32_t getVersion(BufferID buffer) const;
+
     /// Read in a source file from disk.
     SourceBuffer readSource(string_view path);
 
-    /// Read in a header file from disk.
+    /// Read in a header file from disk. Include resolution results, including failures,
+    /// are cached so that repeated includes of the same header don't need to search
+    /// through the include directories again.
     SourceBuffer readHeader(string_view path, SourceLocation includedFrom, bool isSystemPath);
 
     /// Adds a line directive at the given location.
@@ -145,31 +227,72 @@ public:
                           uint8_t level);
 
 private:
-    uint32_t unnamedBufferCount = 0;
+    SourceManagerOptions options;
+    std::atomic<uint32_t> unnamedBufferCount = 0;
 
     // Stores information specified in a `line directive, which alters the
     // line number and file name that we report in diagnostics.
     struct LineDirectiveInfo {
-        std::string name;         // File name set by directive
+        string_view name;         // File name set by directive
         uint32_t lineInFile;      // Actual file line where directive occurred
         uint32_t lineOfDirective; // Line number set by directive
         uint8_t level;            // Level of directive. Either 0, 1, or 2.
 
-        LineDirectiveInfo(std::string&& fname, uint32_t lif, uint32_t lod, uint8_t level) :
-            name(std::move(fname)), lineInFile(lif), lineOfDirective(lod), level(level) {}
+        LineDirectiveInfo(string_view fname, uint32_t lif, uint32_t lod, uint8_t level) :
+            name(fname), lineInFile(lif), lineOfDirective(lod), level(level) {}
+    };
+
+    // A read-only memory mapping of a file on disk. The mapping is padded out to
+    // a whole number of pages with at least one zero byte past the end of the file,
+    // which provides the null terminator that the lexer relies upon.
+    class MappedFile {
+    public:
+        MappedFile(void* base, size_t mappedSize) : base(base), mappedSize(mappedSize) {}
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* data() const { return static_cast<const char*>(base); }
+
+    private:
+        void* base;
+        size_t mappedSize;
     };
 
     // Stores actual file contents and metadata; only one per loaded file
     class FileData {
     public:
         std::string name;                              // name of the file
-        std::vector<char> mem;                         // file contents
+        std::vector<char> mem;                         // file contents, if read into memory
+        std::unique_ptr<MappedFile> mapping;           // file contents, if memory mapped
+        string_view text;                              // file contents, including null terminator
         std::vector<uint32_t> lineOffsets;             // cache of compute line offsets
         std::vector<LineDirectiveInfo> lineDirectives; // cache of line directives
         const fs::path* directory;                     // directory in which the file exists
+        FileData* contentSource = nullptr;             // file that owns our contents, if shared
+        uint32_t version = 0;                          // version of in-memory overlay contents
+        const std::string* diskPath = nullptr;         // path to reload contents from, if any
+        std::atomic<uint32_t> textRefs = 0;            // number of users that need the text
+        std::atomic<bool> textResident = true;         // false if the text has been released
+        size_t textHash = 0;                           // hash of the text before it was released
+        size_t textSize = 0;                           // size of the text before it was released
+        std::atomic<uint32_t> encodingCheck = 0;       // result of getInvalidEncodingOffset
+        std::once_flag lineOffsetsComputed;            // guards lazy computation of lineOffsets
 
         FileData(const fs::path* directory, std::string name, std::vector<char>&& data) :
-            name(std::move(name)), mem(std::move(data)), directory(directory) {}
+            name(std::move(name)), mem(std::move(data)), text(mem.data(), mem.size()),
+            directory(directory) {}
+
+        FileData(const fs::path* directory, std::string name,
+                 std::unique_ptr<MappedFile> mapping, size_t size) :
+            name(std::move(name)),
+            mapping(std::move(mapping)), text(this->mapping->data(), size + 1),
+            directory(directory) {}
+
+        FileData(const fs::path* directory, std::string name, FileData& contentSource) :
+            name(std::move(name)), text(contentSource.text), directory(directory),
+            contentSource(&contentSource) {}
 
         // Returns a pointer to the LineDirectiveInfo for the nearest enclosing
         // line directive of the given raw line number, or nullptr if there is none
@@ -194,32 +317,67 @@ private:
     // at the expansion site. Alternatively, if this token came from an argument,
     // originalLocation will point to the argument at the expansion site and
     // expansionLocation will point to the parameter inside the macro body.
+    //
+    // There can be millions of these, so they're kept as small as possible; whether
+    // this is an argument expansion is stored in the entry kind, and macro names are
+    // stored once in a separate table and referred to by index.
     struct ExpansionInfo {
         SourceLocation originalLoc;
         SourceLocation expansionStart;
         SourceLocation expansionEnd;
-        bool isMacroArg = false;
-
-        string_view macroName;
+        uint32_t macroNameIndex = 0;
 
         ExpansionInfo() {}
         ExpansionInfo(SourceLocation originalLoc, SourceLocation expansionStart,
-                      SourceLocation expansionEnd, bool isMacroArg) :
+                      SourceLocation expansionEnd, uint32_t macroNameIndex) :
             originalLoc(originalLoc),
-            expansionStart(expansionStart), expansionEnd(expansionEnd), isMacroArg(isMacroArg) {}
-
-        ExpansionInfo(SourceLocation originalLoc, SourceLocation expansionStart,
-                      SourceLocation expansionEnd, string_view macroName) :
-            originalLoc(originalLoc),
-            expansionStart(expansionStart), expansionEnd(expansionEnd), macroName(macroName) {}
+            expansionStart(expansionStart), expansionEnd(expansionEnd),
+            macroNameIndex(macroNameIndex) {}
     };
 
-    // index from BufferID to buffer metadata
-    std::deque<std::variant<FileInfo, ExpansionInfo>> bufferEntries;
+    // The kind of data that a particular BufferID refers to.
+    enum class EntryKind : uint8_t { File, Expansion, MacroArgExpansion };
+
+    // Protects all of the mutable state below. Note that the buffer entries can be read
+    // without holding the lock; only adding new entries requires it.
+    mutable std::mutex mut;
+
+    // Protects the line directive lists in all FileData instances.
+    mutable std::shared_mutex lineDirectiveMut;
+
+    // Buffer metadata is stored as a struct of arrays: for each BufferID, the kind of
+    // entry and the index of its data within either the file or the expansion table.
+    AppendOnlyVector<EntryKind> entryKinds;
+    AppendOnlyVector<uint32_t> entryIndices;
+    AppendOnlyVector<FileInfo> fileEntries;
+    AppendOnlyVector<ExpansionInfo> expansionEntries;
+
+    // Names of expanded macros, referenced by index from expansion entries.
+    // Index zero is reserved for expansions without a name. The names are copied
+    // into nameAlloc, since the file text they come from can be released.
+    AppendOnlyVector<string_view> macroNames;
+    std::unordered_map<string_view, uint32_t> macroNameIndices;
+    BumpAllocator nameAlloc;
 
     // cache for file lookups; this holds on to the actual file data
     std::unordered_map<std::string, std::unique_ptr<FileData>> lookupCache;
 
+    // Cache of resolved include directives, keyed by the directory of the including
+    // file (null if not applicable), the name of the include, and whether it was a
+    // system include. Failed lookups are cached as well, as null entries.
+    using IncludeKey = std::tuple<const fs::path*, std::string, bool>;
+    std::unordered_map<IncludeKey, FileData*> includeCache;
+
+    // files loaded from disk indexed by a hash of their contents, for deduplication
+    std::unordered_multimap<size_t, FileData*> contentCache;
+
+    // in-memory overlays that shadow files on disk, keyed by absolute path; the data
+    // for all overlay versions is kept alive in overlayBuffers, though the text of
+    // superseded versions can be dropped by releaseUnusedText
+    std::unordered_map<std::string, FileData*> overlays;
+    std::deque<FileData> overlayBuffers;
+    std::atomic<bool> hasOverlays = false;
+
     // extra file data that came from programmatic buffers instead of a real file on disk
     std::deque<FileData> userFileBuffers;
 
@@ -230,19 +388,42 @@ private:
     // uniquified backing memory for directories
     std::set<fs::path> directories;
 
+    // uniquified backing memory for file names set by line directives
+    std::set<std::string, std::less<>> lineDirectiveNames;
+
     FileData* getFileData(BufferID buffer) const;
+
+    // Gets the text of the given file, reloading it if it has been released.
+    // The second version requires that the caller holds the lock.
+    string_view getText(FileData& fd) const;
+    string_view getTextLocked(FileData& fd) const;
+
+    // Gets the entry for the given buffer; the buffer must be of the matching kind.
+    const FileInfo& getFileInfo(BufferID buffer) const;
+    const ExpansionInfo& getExpansionInfo(BufferID buffer) const;
+
+    // Adds new buffer entries; the caller must hold the lock.
     SourceBuffer createBufferEntry(FileData* fd, SourceLocation includedFrom);
+    SourceLocation createExpansionEntry(EntryKind kind, const ExpansionInfo& info);
 
     SourceBuffer openCached(const fs::path& fullPath, SourceLocation includedFrom);
+
+    SourceBuffer resolveHeader(const fs::path& path, const fs::path* directory,
+                               SourceLocation includedFrom, bool isSystemPath);
+
+    template<typename... Args>
     SourceBuffer cacheBuffer(const fs::path& path, SourceLocation includedFrom,
-                             std::vector<char>&& buffer);
+                             Args&&... fileContents);
 
     // Get raw line number of a file location, ignoring any line directives
     uint32_t getRawLineNumber(SourceLocation location) const;
 
-    static void computeLineOffsets(const std::vector<char>& buffer, std::vector<uint32_t>& offsets);
+    // Gets the line offsets for the given file, computing them if necessary.
+    static const std::vector<uint32_t>& getLineOffsets(FileData& fd);
+    static void computeLineOffsets(string_view buffer, std::vector<uint32_t>& offsets);
 
     static bool readFile(const fs::path& path, std::vector<char>& buffer);
+    static std::unique_ptr<MappedFile> mapFile(const fs::path& path, size_t& size);
 };
 
 } // namespace slang
@@ -0,0 +1,108 @@
+//------------------------------------------------------------------------------
+// AppendOnlyVector.h
+// Growable container with stable elements and lock-free reads.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "slang/numeric/MathUtils.h"
+#include "slang/util/Util.h"
+
+namespace slang {
+
+/// AppendOnlyVector - a random-access container that only supports adding
+/// elements to the end.
+///
+/// Storage is split into a fixed number of segments, each twice the size of
+/// the one before it, so elements never move once they've been added and
+/// references to them remain valid for the lifetime of the container.
+///
+/// Reading existing elements does not require any locking, even while another
+/// thread is appending. Appends themselves must be externally synchronized
+/// (only one thread may append at a time).
+template<typename T, size_t FirstSegmentSize = 64>
+class AppendOnlyVector {
+    static_assert(isPowerOfTwo(FirstSegmentSize));
+
+public:
+    AppendOnlyVector() {
+        for (auto& segment : segments)
+            segment.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~AppendOnlyVector() {
+        size_t remaining = count.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < MaxSegments && remaining; i++) {
+            T* segment = segments[i].load(std::memory_order_relaxed);
+            size_t num = std::min(remaining, segmentSize(i));
+            std::destroy_n(segment, num);
+            ::operator delete(segment);
+            remaining -= num;
+        }
+    }
+
+    AppendOnlyVector(const AppendOnlyVector&) = delete;
+    AppendOnlyVector& operator=(const AppendOnlyVector&) = delete;
+
+    /// Gets the number of elements that have been fully added to the container.
+    size_t size() const { return count.load(std::memory_order_acquire); }
+    bool empty() const { return size() == 0; }
+
+    const T& operator[](size_t index) const {
+        auto [segment, offset] = locate(index);
+        return segments[segment].load(std::memory_order_acquire)[offset];
+    }
+
+    T& operator[](size_t index) {
+        auto [segment, offset] = locate(index);
+        return segments[segment].load(std::memory_order_acquire)[offset];
+    }
+
+    /// Constructs a new element at the end of the container. The new element
+    /// is not visible to readers (via size()) until it has been fully constructed.
+    template<typename... Args>
+    T& emplace_back(Args&&... args) {
+        size_t index = count.load(std::memory_order_relaxed);
+        auto [segment, offset] = locate(index);
+
+        T* storage = segments[segment].load(std::memory_order_relaxed);
+        if (!storage) {
+            storage = static_cast<T*>(::operator new(sizeof(T) * segmentSize(segment)));
+            segments[segment].store(storage, std::memory_order_release);
+        }
+
+        T* result = new (storage + offset) T(std::forward<Args>(args)...);
+        count.store(index + 1, std::memory_order_release);
+        return *result;
+    }
+
+private:
+    static constexpr size_t FirstSegmentShift = [] {
+        size_t shift = 0;
+        for (size_t size = FirstSegmentSize; size > 1; size >>= 1)
+            shift++;
+        return shift;
+    }();
+    static constexpr size_t MaxSegments = 64 - FirstSegmentShift;
+
+    static size_t segmentSize(size_t segment) { return FirstSegmentSize << segment; }
+
+    static std::pair<size_t, size_t> locate(size_t index) {
+        // Segment N holds FirstSegmentSize * 2^N elements, so biasing the index by the
+        // size of the first segment makes its most significant bit select the segment
+        // and the remaining bits the offset within it.
+        uint64_t biased = uint64_t(index) + FirstSegmentSize;
+        size_t msb = 63 - countLeadingZeros64(biased);
+        return { msb - FirstSegmentShift, size_t(biased - (1ull << msb)) };
+    }
+
+    std::atomic<T*> segments[MaxSegments];
+    std::atomic<size_t> count = 0;
+};
+
+} // namespace slang
@@ -44,6 +44,10 @@ public:
         return base;
     }
 
+    /// Gets the total number of bytes handed out by the allocator so far, including
+    /// any padding needed for alignment. This is intended for memory reporting.
+    size_t getBytesAllocated() const;
+
     /// Steals ownership of all of the memory contents of the given allocator.
     /// The other allocator will be in a moved-from state after the call.
     void steal(BumpAllocator&& other);
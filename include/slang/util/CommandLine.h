@@ -0,0 +1,52 @@
+//------------------------------------------------------------------------------
+// CommandLine.h
+// Command file expansion and file name globbing for tool command lines.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "slang/util/Util.h"
+
+namespace fs = std::filesystem;
+
+namespace slang {
+
+/// Expands command files and translates the +plusarg style options commonly found in
+/// file lists into their normal command line equivalents.
+///
+/// Command files are named by -f <file> or -F <file>. Arguments in them are separated
+/// by whitespace, can be quoted, and the file can contain // and # line comments. For
+/// -F files, relative paths in the file are relative to the directory containing the
+/// command file instead of the current directory. Command files can name other
+/// command files.
+///
+/// +incdir+, +define+, and +libext+ are translated to -I, -D, and --libext. Other
+/// plusargs are dropped, and a message about each is added to @a warnings.
+///
+/// Throws std::runtime_error if a command file can't be read, command files are nested
+/// too deeply, or an option is missing its value.
+std::vector<std::string> expandCommandLine(span<const std::string> args,
+                                           std::vector<std::string>& warnings);
+
+/// Checks whether the given path contains any glob wildcards (* or ?).
+bool isGlobPattern(string_view path);
+
+/// Expands glob patterns into matching file names. Patterns can use * and ? within
+/// path components, and ** to match any number of nested directories. Every pattern
+/// must contain at least one wildcard (see isGlobPattern). Symbolic links to directories
+/// are not followed by **, so cycles can't make it recurse forever.
+///
+/// Directories are walked by @a numThreads threads, since on network file systems the
+/// latency of each query matters much more than the amount of work done.
+///
+/// @return the matches for each pattern, in the same order as the patterns.
+/// The matches for each pattern are sorted.
+std::vector<std::vector<fs::path>> expandGlobs(span<const std::string> patterns,
+                                               uint32_t numThreads);
+
+} // namespace slang
@@ -0,0 +1,48 @@
+//------------------------------------------------------------------------------
+// IdentifierTable.h
+// Global interning table for identifier names.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#pragma once
+
+#include "slang/util/Util.h"
+
+namespace slang {
+
+/// A stable 32-bit handle to an interned identifier name. Two names have the same
+/// ID if and only if their text is identical, so IDs can be hashed and compared
+/// much more cheaply than the strings themselves.
+enum class IdentifierId : uint32_t { Invalid = 0 };
+
+/// IdentifierTable - interns identifier names, assigning each distinct name an ID.
+///
+/// There is a single table for the whole process, populated by the lexer as it
+/// encounters identifiers, so that IDs are meaningful across syntax trees and
+/// compilations. Interned text is copied into memory owned by the table; it stays
+/// valid (and its address stays the same) even if the source buffer it came from
+/// is released.
+///
+/// All methods are thread safe. Looking up the text for an ID never takes a lock, and
+/// each thread caches the names it has seen so that repeated lookups don't either.
+/// Names are never removed, since IDs have to stay valid for the life of the process;
+/// the table's size is bounded by the number of distinct names in the inputs.
+class IdentifierTable {
+public:
+    /// Gets the ID for the given name, adding it to the table if it's not already
+    /// present. The empty string always maps to IdentifierId::Invalid.
+    static IdentifierId intern(string_view name);
+
+    /// Gets the ID for the given name if it has been interned previously, or
+    /// IdentifierId::Invalid if it has not. This never modifies the table.
+    static IdentifierId find(string_view name);
+
+    /// Gets the canonical text of the given identifier. Every call for the
+    /// same ID returns a view of the same memory.
+    static string_view getText(IdentifierId id);
+
+    /// Gets the number of distinct names that have been interned.
+    static size_t size();
+};
+
+} // namespace slang
@@ -10,66 +10,64 @@
 
 namespace slang {
 
-/// This class is a lookup table from string to value. It's optimized for
-/// a known fixed set of keywords.
+/// This class is a lookup table from string to value, for a known fixed set of keys.
+/// The tables are generated offline by scripts/keyword_gen.py as minimal perfect
+/// hashes, so a lookup is a single hash of the key followed by a single comparison,
+/// and the tables are constant initialized with no startup cost.
 ///
-/// TODO: use an offline tool to make this a minimal perfect hash.
+/// Keys are hashed into buckets; each bucket has a pair of displacement values that
+/// map its keys to distinct slots in the entry array, which has exactly one slot
+/// per key.
 template<typename T>
 class StringTable {
 public:
-    StringTable(std::initializer_list<std::pair<string_view, T>> entries) {
-        // Give ourselves a bunch of room for entries to hash by using double
-        // the required number of entries. Also round up to power of two so that
-        // we can use bitwise AND instead of mod for wraparound.
-        capacity = (uint32_t)entries.size() * 2;
-        capacity = roundUpToPow2(capacity);
-        table = new Entry[capacity];
+    struct Entry {
+        string_view key;
+        T value;
+    };
 
-        for (auto& entry : entries) {
-            size_t hc = std::hash<string_view>()(entry.first);
-            uint32_t index = hc & (capacity - 1);
-            while (table[index].hashCode != 0)
-                index = (index + 1) & (capacity - 1);
+    struct Displacement {
+        uint16_t d1;
+        uint16_t d2;
+    };
 
-            table[index].key = entry.first;
-            table[index].value = entry.second;
-            table[index].hashCode = hc;
-        }
-    }
+    template<size_t NumEntries, size_t NumBuckets>
+    constexpr StringTable(const Entry (&entries)[NumEntries],
+                          const Displacement (&displacements)[NumBuckets], uint64_t seed) :
+        entries(entries),
+        displacements(displacements), size(NumEntries), numBuckets(NumBuckets), seed(seed) {}
 
     bool lookup(string_view key, T& value) const {
-        size_t hc = std::hash<string_view>()(key);
-        uint32_t index = hc & (capacity - 1);
-        do {
-            if (table[index].hashCode == hc && table[index].key == key) {
-                value = table[index].value;
-                return true;
-            }
-            index = (index + 1) & (capacity - 1);
-        } while (table[index].hashCode != 0);
+        uint64_t hc = hash(key, seed);
+        const Displacement& d = displacements[uint32_t(hc >> 32) % numBuckets];
+        const Entry& entry = entries[(d.d2 + uint64_t(uint32_t(hc)) * d.d1) % size];
+        if (entry.key != key)
+            return false;
 
-        return false;
+        value = entry.value;
+        return true;
     }
 
-private:
-    struct Entry {
-        string_view key;
-        size_t hashCode = 0;
-        T value;
-    };
-    Entry* table;
-    uint32_t capacity;
-
-    static uint32_t roundUpToPow2(uint32_t n) {
-        n--;
-        n |= n >> 1;
-        n |= n >> 2;
-        n |= n >> 4;
-        n |= n >> 8;
-        n |= n >> 16;
-        n++;
-        return n;
+    /// The hash function used by the table; keyword_gen.py must compute exactly the
+    /// same values. This is FNV-1a followed by a final avalanche step.
+    static constexpr uint64_t hash(string_view str, uint64_t seed) {
+        uint64_t h = 14695981039346656037ull ^ seed;
+        for (char c : str) {
+            h ^= uint8_t(c);
+            h *= 1099511628211ull;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return h;
     }
+
+private:
+    const Entry* entries;
+    const Displacement* displacements;
+    uint32_t size;
+    uint32_t numBuckets;
+    uint64_t seed;
 };
 
-} // namespace slang
\ No newline at end of file
+} // namespace slang
@@ -0,0 +1,186 @@
+#!/usr/bin/env python
+# This script generates minimal perfect hash tables for keywords, directives,
+# and other fixed sets of names from a data file.
+import argparse
+import os
+
+MASK64 = (1 << 64) - 1
+
+# Must match StringTable::hash in include/slang/util/StringTable.h
+def hashstr(s, seed):
+    h = 14695981039346656037 ^ seed
+    for c in s.encode('ascii'):
+        h ^= c
+        h = (h * 1099511628211) & MASK64
+    h ^= h >> 33
+    h = (h * 0xff51afd7ed558ccd) & MASK64
+    h ^= h >> 33
+    return h
+
+def trybuild(keys, seed):
+    size = len(keys)
+    numBuckets = (size + 3) // 4
+    buckets = [[] for _ in range(numBuckets)]
+    for i, k in enumerate(keys):
+        h = hashstr(k, seed)
+        buckets[(h >> 32) % numBuckets].append((i, h & 0xffffffff))
+
+    slots = [None] * size
+    disps = [(0, 0)] * numBuckets
+    order = sorted(range(numBuckets), key=lambda b: len(buckets[b]), reverse=True)
+    for b in order:
+        bucket = buckets[b]
+        if not bucket:
+            continue
+
+        found = False
+        for d1 in range(size):
+            for d2 in range(size):
+                positions = [(d2 + f1 * d1) % size for _, f1 in bucket]
+                if len(set(positions)) != len(positions):
+                    continue
+                if any(slots[p] is not None for p in positions):
+                    continue
+
+                for (i, _), p in zip(bucket, positions):
+                    slots[p] = i
+                disps[b] = (d1, d2)
+                found = True
+                break
+            if found:
+                break
+
+        if not found:
+            return None
+
+    return (slots, disps)
+
+def build(keys):
+    assert len(keys) < 65536
+    assert len(set(keys)) == len(keys)
+    for seed in range(1000):
+        result = trybuild(keys, seed)
+        if result:
+            return (seed, result[0], result[1])
+    raise Exception('Failed to build perfect hash table')
+
+def writetable(outf, name, type, entries, static=False):
+    keys = [e[0] for e in entries]
+    seed, slots, disps = build(keys)
+
+    outf.write('constexpr StringTable<{}>::Entry {}_entries[] = {{\n'.format(type, name))
+    for i in slots:
+        outf.write('    {{ "{}", {}::{} }},\n'.format(entries[i][0], type, entries[i][1]))
+    outf.write('};\n\n')
+
+    outf.write('constexpr StringTable<{}>::Displacement {}_displacements[] = {{\n'.format(
+        type, name))
+    for i in range(0, len(disps), 6):
+        line = ', '.join('{{ {}, {} }}'.format(d[0], d[1]) for d in disps[i:i + 6])
+        outf.write('    {},\n'.format(line))
+    outf.write('};\n\n')
+
+    if not static:
+        outf.write('constexpr StringTable<{0}> {1}({1}_entries, {1}_displacements, {2});\n\n'
+                   .format(type, name, seed))
+    return seed
+
+def main():
+    parser = argparse.ArgumentParser(description='Keyword table generator')
+    parser.add_argument('--dir', default=os.getcwd(), help='Output directory')
+    args = parser.parse_args()
+
+    ourdir = os.path.dirname(os.path.realpath(__file__))
+    inf = open(os.path.join(ourdir, "keywords.txt"))
+
+    headerdir = os.path.join(args.dir, 'slang', 'parsing')
+    try:
+        os.makedirs(headerdir)
+    except OSError:
+        pass
+
+    tables = []
+    versions = []
+    current = None
+
+    for line in [x.strip() for x in inf]:
+        if not line or line.startswith('//'):
+            continue
+
+        parts = line.strip('[]').split()
+        if line.startswith('[') and parts[0] == 'table':
+            current = []
+            tables.append((parts[1], parts[2], current))
+        elif line.startswith('[') and parts[0] == 'keywords':
+            current = []
+            versions.append((parts[1], parts[2], current))
+        elif len(parts) == 2 and current is not None:
+            current.append((parts[0], parts[1]))
+        else:
+            raise Exception('Invalid entry: {}'.format(line))
+
+    createheader(open(os.path.join(headerdir, "KeywordTables.h"), 'w'), tables, versions)
+    createsource(open(os.path.join(args.dir, "KeywordTables.cpp"), 'w'), tables, versions)
+
+def createheader(outf, tables, versions):
+    outf.write('''//------------------------------------------------------------------------------
+// KeywordTables.h
+// Generated keyword lookup tables.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#pragma once
+
+#include "slang/parsing/Token.h"
+#include "slang/syntax/SyntaxKind.h"
+#include "slang/util/StringTable.h"
+
+namespace slang {
+
+''')
+
+    for name, type, _ in tables:
+        outf.write('extern const StringTable<{}> {};\n'.format(type, name))
+
+    outf.write('''extern const StringTable<KeywordVersion> keywordVersionTable;
+
+// A separate table of keywords for each KeywordVersion, indexed by version.
+extern const StringTable<TokenKind> allKeywords[{}];
+
+}}
+'''.format(len(versions)))
+
+def createsource(outf, tables, versions):
+    outf.write('''//------------------------------------------------------------------------------
+// KeywordTables.cpp
+// Generated keyword lookup tables.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#include "slang/parsing/KeywordTables.h"
+
+namespace slang {
+
+''')
+
+    for name, type, entries in tables:
+        writetable(outf, name, type, entries)
+
+    writetable(outf, 'keywordVersionTable', 'KeywordVersion',
+               [(v[1], v[0]) for v in versions])
+
+    # Each version's keyword table includes everything introduced before it.
+    seeds = []
+    keywords = []
+    for version, _, entries in versions:
+        keywords = keywords + entries
+        seeds.append(writetable(outf, 'keywords_' + version, 'TokenKind', keywords, True))
+
+    outf.write('constexpr StringTable<TokenKind> allKeywords[{}] = {{\n'.format(len(versions)))
+    for (version, _, _), seed in zip(versions, seeds):
+        outf.write('    {{ keywords_{0}_entries, keywords_{0}_displacements, {1} }},\n'.format(
+            version, seed))
+    outf.write('};\n\n}\n')
+
+if __name__ == "__main__":
+    main()
@@ -262,6 +262,16 @@ const CompilationUnitSymbol* Compilation::getCompilationUnit(
 
 const DefinitionSymbol* Compilation::getDefinition(string_view lookupName,
                                                    const Scope& scope) const {
+    // A name that has never been interned can't belong to any definition.
+    IdentifierId id = IdentifierTable::find(lookupName);
+    if (id == IdentifierId::Invalid)
+        return nullptr;
+
+    return getDefinition(id, scope);
+}
+
+const DefinitionSymbol* Compilation::getDefinition(IdentifierId lookupName,
+                                                   const Scope& scope) const {
     const Scope* searchScope = &scope;
     while (true) {
         auto it = definitionMap.find(std::make_tuple(lookupName, searchScope));
@@ -287,17 +297,21 @@ void Compilation::addDefinition(const DefinitionSymbol& definition) {
     const Scope* scope = definition.getScope();
     ASSERT(scope);
 
+    IdentifierId name = IdentifierTable::intern(definition.name);
     if (scope->asSymbol().kind == SymbolKind::CompilationUnit) {
-        definitionMap.emplace(std::make_tuple(definition.name, root.get()),
+        definitionMap.emplace(std::make_tuple(name, root.get()),
                               std::make_tuple(&definition, false));
     }
     else {
-        definitionMap.emplace(std::make_tuple(definition.name, scope),
-                              std::make_tuple(&definition, false));
+        definitionMap.emplace(std::make_tuple(name, scope), std::make_tuple(&definition, false));
     }
 }
 
 const PackageSymbol* Compilation::getPackage(string_view lookupName) const {
+    return getPackage(IdentifierTable::find(lookupName));
+}
+
+const PackageSymbol* Compilation::getPackage(IdentifierId lookupName) const {
     auto it = packageMap.find(lookupName);
     if (it == packageMap.end())
         return nullptr;
@@ -305,7 +319,7 @@ const PackageSymbol* Compilation::getPackage(string_view lookupName) const {
 }
 
 void Compilation::addPackage(const PackageSymbol& package) {
-    packageMap.emplace(package.name, &package);
+    packageMap.emplace(IdentifierTable::intern(package.name), &package);
 }
 
 void Compilation::addSystemSubroutine(std::unique_ptr<SystemSubroutine> subroutine) {
@@ -6,18 +6,22 @@
 //------------------------------------------------------------------------------
 #include "slang/numeric/Time.h"
 
-#include "slang/util/StringTable.h"
-
 namespace slang {
 
-const static StringTable<TimeUnit> strToUnit = {
+static constexpr std::pair<string_view, TimeUnit> strToUnit[] = {
     { "s", TimeUnit::Seconds },       { "ms", TimeUnit::Milliseconds },
     { "us", TimeUnit::Microseconds }, { "ns", TimeUnit::Nanoseconds },
     { "ps", TimeUnit::Picoseconds },  { "fs", TimeUnit::Femtoseconds }
 };
 
 bool suffixToTimeUnit(string_view timeSuffix, TimeUnit& unit) {
-    return strToUnit.lookup(timeSuffix, unit);
+    for (auto& [str, value] : strToUnit) {
+        if (str == timeSuffix) {
+            unit = value;
+            return true;
+        }
+    }
+    return false;
 }
 
 string_view timeUnitToSuffix(TimeUnit unit) {
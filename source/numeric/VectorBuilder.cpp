@@ -9,6 +9,7 @@
 #include "../text/CharInfo.h"
 
 #include "slang/diagnostics/Diagnostics.h"
+#include "slang/numeric/MathUtils.h"
 
 namespace slang {
 
@@ -26,6 +27,24 @@ void VectorBuilder::start(LiteralBase base, bitwidth_t size, bool isSigned,
     valid = true;
     first = true;
     digits.clear();
+
+    packedWords.clear();
+    packedBits = 0;
+    switch (base) {
+        case LiteralBase::Binary:
+            bitsPerDigit = 1;
+            break;
+        case LiteralBase::Octal:
+            bitsPerDigit = 3;
+            break;
+        case LiteralBase::Hex:
+            bitsPerDigit = 4;
+            break;
+        default:
+            bitsPerDigit = 0;
+            break;
+    }
+    packed = bitsPerDigit != 0;
 }
 
 void VectorBuilder::append(Token token) {
@@ -49,10 +68,22 @@ void VectorBuilder::append(Token token) {
         return;
     }
 
-    int index = 0;
+    // Take the fast path for as long as the digits are all known.
+    size_t index = 0;
+    if (packed) {
+        index = appendPacked(text);
+        if (index == text.length()) {
+            first = false;
+            valid = true;
+            return;
+        }
+        unpack();
+    }
+
     switch (literalBase) {
         case LiteralBase::Binary:
-            for (char c : text) {
+            for (; index < text.length(); index++) {
+                char c = text[index];
                 if (isLogicDigit(c))
                     addDigit(getLogicCharValue(c), 2);
                 else if (isBinaryDigit(c))
@@ -61,11 +92,11 @@ void VectorBuilder::append(Token token) {
                     diagnostics.add(DiagCode::BadBinaryDigit, location + index);
                     return;
                 }
-                index++;
             }
             break;
         case LiteralBase::Octal:
-            for (char c : text) {
+            for (; index < text.length(); index++) {
+                char c = text[index];
                 if (isLogicDigit(c))
                     addDigit(getLogicCharValue(c), 8);
                 else if (isOctalDigit(c))
@@ -74,7 +105,6 @@ void VectorBuilder::append(Token token) {
                     diagnostics.add(DiagCode::BadOctalDigit, location + index);
                     return;
                 }
-                index++;
             }
             break;
         case LiteralBase::Decimal:
@@ -84,7 +114,8 @@ void VectorBuilder::append(Token token) {
                 break;
             }
 
-            for (char c : text) {
+            for (; index < text.length(); index++) {
+                char c = text[index];
                 if (isLogicDigit(c)) {
                     diagnostics.add(DiagCode::DecimalDigitMultipleUnknown, location + index);
                     return;
@@ -95,11 +126,11 @@ void VectorBuilder::append(Token token) {
                     diagnostics.add(DiagCode::BadDecimalDigit, location + index);
                     return;
                 }
-                index++;
             }
             break;
         case LiteralBase::Hex:
-            for (char c : text) {
+            for (; index < text.length(); index++) {
+                char c = text[index];
                 if (isLogicDigit(c))
                     addDigit(getLogicCharValue(c), 16);
                 else if (isHexDigit(c))
@@ -108,7 +139,6 @@ void VectorBuilder::append(Token token) {
                     diagnostics.add(DiagCode::BadHexDigit, location + index);
                     return;
                 }
-                index++;
             }
             break;
         default:
@@ -123,6 +153,9 @@ SVInt VectorBuilder::finish() {
     if (!valid)
         return 0;
 
+    if (packed)
+        return finishPacked();
+
     if (digits.empty())
         digits.append(logic_t(0));
     else if (literalBase == LiteralBase::Decimal) {
@@ -186,6 +219,153 @@ SVInt VectorBuilder::finish() {
     return SVInt::fromDigits(sizeBits ? sizeBits : 32, literalBase, signFlag, hasUnknown, digits);
 }
 
+size_t VectorBuilder::appendPacked(string_view text) {
+    // Returns the index of the first character that isn't a known digit or an underscore,
+    // which is left for the caller to deal with.
+    size_t index = 0;
+    while (index < text.length()) {
+        // Try to take a whole word's worth of digits at once.
+        if (text.length() - index >= 8) {
+            uint64_t chars = swar::loadChars(text.data() + index);
+            uint64_t values;
+            bool good;
+            switch (literalBase) {
+                case LiteralBase::Binary:
+                    good = swar::allBinaryDigits(chars);
+                    values = chars & swar::Ones;
+                    break;
+                case LiteralBase::Octal:
+                    good = swar::allOctalDigits(chars);
+                    values = chars & (swar::Ones * 7);
+                    break;
+                default:
+                    good = swar::allHexDigits(chars);
+                    values = swar::getHexDigitValues(chars);
+                    break;
+            }
+
+            if (good) {
+                addPackedDigits(swar::packDigits(values, bitsPerDigit), 8);
+                index += 8;
+                continue;
+            }
+        }
+
+        char c = text[index];
+        if (c != '_') {
+            bool good;
+            switch (literalBase) {
+                case LiteralBase::Binary:
+                    good = isBinaryDigit(c);
+                    break;
+                case LiteralBase::Octal:
+                    good = isOctalDigit(c);
+                    break;
+                default:
+                    good = isHexDigit(c);
+                    break;
+            }
+
+            if (!good)
+                return index;
+
+            addPackedDigits(getHexDigitValue(c), 1);
+        }
+        index++;
+    }
+    return index;
+}
+
+void VectorBuilder::addPackedDigits(uint64_t value, uint32_t count) {
+    // Leading zeros don't count towards our bit limit, so drop them
+    // until we've seen a non-zero digit.
+    if (packedBits == 0) {
+        if (value == 0)
+            return;
+
+        uint32_t significantBits = 64 - countLeadingZeros64(value);
+        count = (significantBits + bitsPerDigit - 1) / bitsPerDigit;
+    }
+
+    // Append the bits to the stream, which is left aligned within each word.
+    uint32_t bits = count * bitsPerDigit;
+    uint32_t used = uint32_t(packedBits % 64);
+    if (used == 0) {
+        packedWords.append(value << (64 - bits));
+    }
+    else if (used + bits <= 64) {
+        packedWords.back() |= value << (64 - used - bits);
+    }
+    else {
+        uint32_t remaining = used + bits - 64;
+        packedWords.back() |= value >> remaining;
+        packedWords.append(value << (64 - remaining));
+    }
+    packedBits += bits;
+}
+
+uint64_t VectorBuilder::getPackedBits(size_t start, uint32_t count) const {
+    // Gets @a count bits (at most 64) from the stream starting at the given bit
+    // position, counting from the most significant end, and right aligns them.
+    size_t word = start / 64;
+    uint32_t offset = uint32_t(start % 64);
+    uint64_t result = packedWords[word] << offset;
+    if (offset + count > 64)
+        result |= packedWords[word + 1] >> (64 - offset);
+    return result >> (64 - count);
+}
+
+void VectorBuilder::unpack() {
+    // Move all packed digits over to the digit list; leading zeros have already
+    // been dropped so no need to go through addDigit.
+    for (size_t i = 0; i < packedBits; i += bitsPerDigit)
+        digits.append(logic_t(uint8_t(getPackedBits(i, bitsPerDigit))));
+
+    packedWords.clear();
+    packedBits = 0;
+    packed = false;
+}
+
+SVInt VectorBuilder::finishPacked() {
+    // The first packed digit is never zero, so the number of significant bits
+    // is easy to determine directly from the stream.
+    bitwidth_t bits = 0;
+    if (packedBits)
+        bits = bitwidth_t(packedBits - countLeadingZeros64(packedWords[0]));
+
+    // This mirrors the size checking done for the digit list in finish().
+    bitwidth_t width = sizeBits ? sizeBits : 32;
+    if (bits > sizeBits) {
+        if (bits > SVInt::MAX_BITS) {
+            diagnostics.add(DiagCode::VectorLiteralOverflow, firstLocation);
+            bits = SVInt::MAX_BITS;
+        }
+        if (sizeBits == 0)
+            width = std::max(32u, bits);
+        else
+            diagnostics.add(DiagCode::VectorLiteralOverflow, firstLocation);
+    }
+
+    // Build the words of the result starting from the least significant end of the
+    // stream. If the literal is too large for the width it gets truncated from the left.
+    SmallVectorSized<uint64_t, 4> words;
+    size_t numWords = std::min(size_t(width + 63) / 64, (packedBits + 63) / 64);
+    for (size_t i = 0; i < numWords; i++) {
+        size_t end = packedBits - i * 64;
+        if (end >= 64)
+            words.append(getPackedBits(end - 64, 64));
+        else
+            words.append(getPackedBits(0, uint32_t(end)));
+    }
+
+    if (words.empty())
+        words.append(0);
+
+    span<const byte> bytes(reinterpret_cast<const byte*>(words.data()),
+                           words.size() * sizeof(uint64_t));
+    return SVInt(width, bytes, signFlag);
+}
+
 void VectorBuilder::addDigit(logic_t digit, int maxValue) {
     // Leading zeros obviously don't count towards our bit limit, so
     // only count them if we've seen other non-zero digits
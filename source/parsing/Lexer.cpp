@@ -7,9 +7,11 @@
 #include "slang/parsing/Lexer.h"
 
 #include "../text/CharInfo.h"
+#include "../text/SIMD.h"
 #include <algorithm>
 #include <cmath>
 
+#include "slang/numeric/MathUtils.h"
 #include "slang/syntax/SyntaxNode.h"
 #include "slang/text/SourceManager.h"
 #include "slang/util/BumpAllocator.h"
@@ -92,6 +94,18 @@ Lexer::Lexer(BufferID bufferId, string_view source, const char* startPtr, BumpAl
             }
         }
     }
+
+    // Lexers that start partway into a buffer are only used to relex pieces of
+    // tokens, which have already been through this check.
+    if (startPtr == originalBegin && options.checkEncoding)
+        checkEncoding();
+}
+
+Lexer::~Lexer() {
+    // A lexer that stops before the end of its buffer never finishes recording,
+    // so let the cache throw away what it has so far.
+    if (cacheRecorder)
+        options.tokenCache->discard(*cacheRecorder);
 }
 
 Token Lexer::concatenateTokens(BumpAllocator& alloc, Token left, Token right) {
@@ -127,7 +141,7 @@ Token Lexer::concatenateTokens(BumpAllocator& alloc, Token left, Token right) {
 
     auto info = alloc.emplace<Token::Info>(*token.getInfo());
     info->location = location;
-    info->trivia = trivia;
+    info->setTrivia(trivia);
     return Token(token.kind, info);
 }
 
@@ -167,8 +181,8 @@ Token Lexer::stringify(BumpAllocator& alloc, SourceLocation location, span<Trivi
 
     auto info = alloc.emplace<Token::Info>(*token.getInfo());
     info->location = location;
-    info->trivia = trivia;
-    info->rawText = raw.substr(0, raw.length() - 1);
+    info->setTrivia(trivia);
+    info->setRawText(raw.substr(0, raw.length() - 1));
     return Token(token.kind, info);
 }
 
@@ -197,6 +211,12 @@ void Lexer::splitTokens(BumpAllocator& alloc, Diagnostics& diagnostics,
 }
 
 Token Lexer::lex(KeywordVersion keywordVersion) {
+    if (options.tokenCache) {
+        Token token;
+        if (lexCached(keywordVersion, token))
+            return token;
+    }
+
     auto info = alloc.emplace<Token::Info>();
     SmallVectorSized<Trivia, 32> triviaBuffer;
     lexTrivia(triviaBuffer);
@@ -205,7 +225,7 @@ Token Lexer::lex(KeywordVersion keywordVersion) {
     mark();
     TokenKind kind = lexToken(info, keywordVersion);
     onNewLine = false;
-    info->rawText = lexeme();
+    info->setRawText(lexeme());
 
     if (kind != TokenKind::EndOfFile && diagnostics.size() > options.maxErrors) {
         // Stop any further lexing by claiming to be at the end of the buffer.
@@ -215,8 +235,59 @@ Token Lexer::lex(KeywordVersion keywordVersion) {
         triviaBuffer.append(Trivia(TriviaKind::DisabledText, lexeme()));
         kind = TokenKind::EndOfFile;
     }
-    info->trivia = triviaBuffer.copy(alloc);
-    return Token(kind, info);
+
+    if (options.preserveTrivia)
+        info->setTrivia(triviaBuffer.copy(alloc));
+    else
+        info->setTrivia(discardTrivia(triviaBuffer));
+
+    Token token(kind, info);
+    if (cacheRecorder)
+        recordCached(token, keywordVersion);
+    return token;
+}
+
+bool Lexer::lexCached(KeywordVersion keywordVersion, Token& result) {
+    if (!cacheChecked) {
+        // Only whole buffers are cached, and only if they lex cleanly, so give up
+        // right away if the lexer started partway in or already found a problem
+        // such as a byte order mark.
+        cacheChecked = true;
+        if (sourceBuffer != originalBegin || errorCount)
+            return false;
+
+        string_view source(originalBegin, size_t(sourceEnd - originalBegin));
+        cachedTokens = options.tokenCache->lookup(source, options.preserveTrivia,
+                                                  keywordVersion, cacheRecorder);
+    }
+
+    if (!cachedTokens)
+        return false;
+
+    uint32_t resumeOffset;
+    if (TokenCache::replay(*cachedTokens, cacheIndex, keywordVersion, bufferId, originalBegin,
+                           alloc, result, resumeOffset)) {
+        cacheIndex++;
+        onNewLine = false;
+        return true;
+    }
+
+    // The keyword version differs from the one the cached tokens were lexed with,
+    // so lex the rest of the buffer from scratch, picking up where replay left off.
+    sourceBuffer = originalBegin + resumeOffset;
+    cachedTokens = nullptr;
+    return false;
+}
+
+void Lexer::recordCached(Token token, KeywordVersion keywordVersion) {
+    // Diagnostics can't be replayed, so stop recording once there are any.
+    if (errorCount) {
+        options.tokenCache->discard(*cacheRecorder);
+        cacheRecorder = nullptr;
+    }
+    else if (!options.tokenCache->record(*cacheRecorder, token, keywordVersion)) {
+        cacheRecorder = nullptr;
+    }
 }
 
 TokenKind Lexer::lexToken(Token::Info* info, KeywordVersion keywordVersion) {
@@ -513,13 +584,18 @@ TokenKind Lexer::lexToken(Token::Info* info, KeywordVersion keywordVersion) {
             if (getKeywordTable(keywordVersion)->lookup(lexeme(), kind))
                 return kind;
 
-            info->extra = IdentifierType::Normal;
+            info->extra.idType = IdentifierType::Normal;
+            info->identifierId = IdentifierTable::intern(lexeme());
             return TokenKind::Identifier;
         }
         case '[':
             return TokenKind::OpenBracket;
-        case '\\':
-            return lexEscapeSequence(info);
+        case '\\': {
+            TokenKind kind = lexEscapeSequence(info);
+            if (kind == TokenKind::Identifier)
+                info->identifierId = IdentifierTable::intern(lexeme().substr(1));
+            return kind;
+        }
         case ']':
             return TokenKind::CloseBracket;
         case '^':
@@ -594,9 +670,10 @@ TokenKind Lexer::lexToken(Token::Info* info, KeywordVersion keywordVersion) {
             if (isASCII(c))
                 addDiag(DiagCode::NonPrintableChar, offset);
             else {
-                // skip over UTF-8 sequences
-                advance(utf8SeqBytes(c));
-                addDiag(DiagCode::UTF8Char, offset);
+                // skip over the whole UTF-8 sequence, or just the part of it that's invalid
+                bool valid;
+                advance(getUTF8SeqLength(sourceBuffer - 1, valid) - 1);
+                addDiag(valid ? DiagCode::UTF8Char : DiagCode::InvalidUTF8Seq, offset);
             }
             return TokenKind::Unknown;
     }
@@ -690,7 +767,7 @@ void Lexer::lexStringLiteral(Token::Info* info) {
         }
     }
 
-    info->extra = to_string_view(stringBuffer.copy(alloc));
+    info->setStringText(alloc, to_string_view(stringBuffer.copy(alloc)));
 }
 
 TokenKind Lexer::lexEscapeSequence(Token::Info* info) {
@@ -715,7 +792,7 @@ TokenKind Lexer::lexEscapeSequence(Token::Info* info) {
             break;
     }
 
-    info->extra = IdentifierType::Escaped;
+    info->extra.idType = IdentifierType::Escaped;
     return TokenKind::Identifier;
 }
 
@@ -732,7 +809,7 @@ TokenKind Lexer::lexDollarSign(Token::Info* info) {
     if (kind != TokenKind::Unknown)
         return kind;
 
-    info->extra = IdentifierType::System;
+    info->extra.idType = IdentifierType::System;
     return TokenKind::Identifier;
 }
 
@@ -741,7 +818,8 @@ TokenKind Lexer::lexDirective(Token::Info* info) {
         // Handle escaped macro names as well.
         TokenKind kind = lexEscapeSequence(info);
         if (kind == TokenKind::Identifier) {
-            info->extra = SyntaxKind::MacroUsage;
+            info->extra.directiveKind = SyntaxKind::MacroUsage;
+            info->identifierId = IdentifierTable::intern(lexeme().substr(2));
             return TokenKind::Directive;
         }
         return TokenKind::Unknown;
@@ -754,12 +832,14 @@ TokenKind Lexer::lexDirective(Token::Info* info) {
     // if length is 1, we just have a grave character on its own, which is an error
     if (lexemeLength() == 1) {
         addDiag(DiagCode::MisplacedDirectiveChar, startingOffset);
-        info->extra = SyntaxKind::Unknown;
+        info->extra.directiveKind = SyntaxKind::Unknown;
         return TokenKind::Directive;
     }
 
-    info->extra = getDirectiveKind(lexeme().substr(1));
-    if (!onNewLine && std::get<SyntaxKind>(info->extra) == SyntaxKind::IncludeDirective)
+    info->extra.directiveKind = getDirectiveKind(lexeme().substr(1));
+    if (info->extra.directiveKind == SyntaxKind::MacroUsage)
+        info->identifierId = IdentifierTable::intern(lexeme().substr(1));
+    if (!onNewLine && info->extra.directiveKind == SyntaxKind::IncludeDirective)
         addDiag(DiagCode::IncludeNotFirstOnLine, startingOffset);
 
     return TokenKind::Directive;
@@ -994,23 +1074,122 @@ void Lexer::scanIdentifier() {
 
 void Lexer::scanUnsignedNumber(uint64_t& value, int& digits) {
     while (true) {
+        // Convert eight digits at a time while there are enough of them in a row.
+        // This is only tried once per run of digits, since most numbers are short.
+        while (digits + 8 <= MaxMantissaDigits && sourceEnd - sourceBuffer >= 8) {
+            uint64_t chars = swar::loadChars(sourceBuffer);
+            if (!swar::allDecimalDigits(chars))
+                break;
+
+            value = (value * 100000000) + swar::getDecimalValue(chars);
+            digits += 8;
+            advance(8);
+        }
+
         char c = peek();
-        if (c == '_')
-            advance();
-        else if (!isDecimalDigit(c))
-            return;
-        else {
+        while (isDecimalDigit(c)) {
             // After 18 digits stop caring. For normal integers we're going to truncate
             // to 32-bits anyway. For reals, later digits won't have any effect on the result.
             if (digits < MaxMantissaDigits)
                 value = (value * 10) + getDigitValue(c);
             digits++;
             advance();
+            c = peek();
+        }
+
+        if (c != '_')
+            return;
+        advance();
+    }
+}
+
+// Skips over characters a whole block at a time until reaching one of the given
+// characters. Stops early when there isn't a full block left before the end of the
+// buffer, leaving the rest to the caller's scalar loop.
+template<char... Cs>
+static const char* skipUntilAny(const char* ptr, const char* end) {
+#if defined(SLANG_HAS_SIMD)
+    while (end - ptr >= (ptrdiff_t)simd::BlockSize) {
+        uint32_t mask = simd::matchAny<Cs...>(ptr);
+        if (mask)
+            return ptr + countTrailingZeros32(mask);
+        ptr += simd::BlockSize;
+    }
+#else
+    (void)end;
+#endif
+    return ptr;
+}
+
+// Like skipUntilAny, but skips over characters that are any of the given characters.
+template<char... Cs>
+static const char* skipWhileAny(const char* ptr, const char* end) {
+#if defined(SLANG_HAS_SIMD)
+    while (end - ptr >= (ptrdiff_t)simd::BlockSize) {
+        uint32_t mask = ~simd::matchAny<Cs...>(ptr) & simd::FullMask;
+        if (mask)
+            return ptr + countTrailingZeros32(mask);
+        ptr += simd::BlockSize;
+    }
+#else
+    (void)end;
+#endif
+    return ptr;
+}
+
+// Shared trivia used in place of the real thing when trivia is not being preserved.
+static const Trivia canonicalSpace[] = { Trivia(TriviaKind::Whitespace, " ") };
+static const Trivia canonicalNewline[] = { Trivia(TriviaKind::EndOfLine, "\n") };
+
+span<Trivia const> Lexer::discardTrivia(const SmallVector<Trivia>& triviaBuffer) {
+    if (triviaBuffer.empty())
+        return {};
+
+    // Keep only the trivia that the preprocessor looks at when deciding where a
+    // directive ends, and collapse everything else. Runs of blank lines become a
+    // single newline, except that the newline ending a line comment with a trailing
+    // line continuation doesn't count towards the run.
+    SmallVectorSized<Trivia, 8> kept;
+    auto isRedundantNewline = [&kept]() {
+        size_t size = kept.size();
+        return size && kept[size - 1].kind == TriviaKind::EndOfLine &&
+               (size == 1 || kept[size - 2].kind != TriviaKind::LineComment);
+    };
+
+    for (const Trivia& trivia : triviaBuffer) {
+        switch (trivia.kind) {
+            case TriviaKind::EndOfLine:
+                if (!isRedundantNewline())
+                    kept.append(trivia);
+                break;
+            case TriviaKind::LineComment:
+                if (trivia.getRawText().back() == '\\')
+                    kept.append(trivia);
+                break;
+            case TriviaKind::BlockComment:
+                if (trivia.getRawText().find_first_of("\r\n") != string_view::npos)
+                    kept.append(trivia);
+                break;
+            case TriviaKind::Whitespace:
+                break;
+            default:
+                kept.append(trivia);
+                break;
         }
     }
+
+    if (kept.empty())
+        return canonicalSpace;
+
+    if (kept.size() == 1 && kept[0].kind == TriviaKind::EndOfLine)
+        return canonicalNewline;
+
+    return kept.copy(alloc);
 }
 
 void Lexer::scanWhitespace(SmallVector<Trivia>& triviaBuffer) {
+    sourceBuffer = skipWhileAny<' ', '\t', '\v', '\f'>(sourceBuffer, sourceEnd);
+
     bool done = false;
     while (!done) {
         switch (peek()) {
@@ -1030,6 +1209,8 @@ void Lexer::scanWhitespace(SmallVector<Trivia>& triviaBuffer) {
 
 void Lexer::scanLineComment(SmallVector<Trivia>& triviaBuffer) {
     while (true) {
+        sourceBuffer = skipUntilAny<'\n', '\r', '\0'>(sourceBuffer, sourceEnd);
+
         char c = peek();
         if (isNewline(c))
             break;
@@ -1048,6 +1229,8 @@ void Lexer::scanLineComment(SmallVector<Trivia>& triviaBuffer) {
 
 void Lexer::scanBlockComment(SmallVector<Trivia>& triviaBuffer) {
     while (true) {
+        sourceBuffer = skipUntilAny<'*', '/', '\0'>(sourceBuffer, sourceEnd);
+
         char c = peek();
         if (c == '\0') {
             if (reallyAtEnd()) {
@@ -1076,6 +1259,156 @@ void Lexer::scanBlockComment(SmallVector<Trivia>& triviaBuffer) {
     addTrivia(TriviaKind::BlockComment, triviaBuffer);
 }
 
+bool Lexer::skipDisabledText(string_view& text, SourceLocation& location) {
+    // Replaying or recording cached tokens requires seeing every token in the buffer.
+    if (options.tokenCache)
+        return false;
+
+    const char* start = sourceBuffer;
+    int depth = 0;
+    while (true) {
+        // Only a handful of characters can change how the text around them is interpreted;
+        // jump straight from one to the next.
+        sourceBuffer = skipUntilAny<'`', '"', '/', '\\', '\0'>(sourceBuffer, sourceEnd);
+
+        char c = peek();
+        if (c == '\0') {
+            if (reallyAtEnd())
+                break;
+            advance();
+        }
+        else if (c == '/') {
+            advance();
+            if (consume('/')) {
+                while (true) {
+                    sourceBuffer = skipUntilAny<'\n', '\r', '\0'>(sourceBuffer, sourceEnd);
+                    c = peek();
+                    if (isNewline(c) || (c == '\0' && reallyAtEnd()))
+                        break;
+                    advance();
+                }
+            }
+            else if (consume('*')) {
+                while (true) {
+                    sourceBuffer = skipUntilAny<'*', '\0'>(sourceBuffer, sourceEnd);
+                    c = peek();
+                    if (c == '*' && peek(1) == '/') {
+                        advance(2);
+                        break;
+                    }
+                    if (c == '\0' && reallyAtEnd())
+                        break;
+                    advance();
+                }
+            }
+        }
+        else if (c == '"') {
+            // String literals end at the closing quote or at the end of the line,
+            // unless the newline is escaped.
+            advance();
+            while (true) {
+                sourceBuffer = skipUntilAny<'"', '\\', '\n', '\r', '\0'>(sourceBuffer, sourceEnd);
+                c = peek();
+                if (c == '"') {
+                    advance();
+                    break;
+                }
+                if (isNewline(c) || (c == '\0' && reallyAtEnd()))
+                    break;
+
+                advance();
+                if (c == '\\') {
+                    c = peek();
+                    if (c == '\0' && reallyAtEnd())
+                        break;
+                    advance();
+                    if (c == '\r')
+                        consume('\n');
+                }
+            }
+        }
+        else if (c == '\\') {
+            // Escaped identifiers can contain any printable character.
+            advance();
+            while (isPrintable(peek()))
+                advance();
+        }
+        else if (c != '`') {
+            // the block scan stops short near the end of the buffer
+            advance();
+        }
+        else {
+            const char* directiveStart = sourceBuffer;
+            advance();
+            c = peek();
+            if (c == '"' || c == '`') {
+                advance();
+                continue;
+            }
+            if (c == '\\') {
+                if (peek(1) == '`' && peek(2) == '"') {
+                    advance(3);
+                    continue;
+                }
+
+                // escaped macro name
+                advance();
+                while (isPrintable(peek()))
+                    advance();
+                continue;
+            }
+
+            mark();
+            scanIdentifier();
+            switch (getDirectiveKind(lexeme())) {
+                case SyntaxKind::IfDefDirective:
+                case SyntaxKind::IfNDefDirective:
+                    depth++;
+                    continue;
+                case SyntaxKind::EndIfDirective:
+                    if (depth) {
+                        depth--;
+                        continue;
+                    }
+                    break;
+                case SyntaxKind::ElsIfDirective:
+                case SyntaxKind::ElseDirective:
+                    if (depth)
+                        continue;
+                    break;
+                default:
+                    continue;
+            }
+
+            // This directive ends the block, so leave it to be lexed normally.
+            sourceBuffer = directiveStart;
+            break;
+        }
+    }
+
+    // Leave any whitespace before the directive to be lexed as its trivia, which is
+    // where it would have ended up if all of the tokens in the block had been lexed.
+    // That also takes care of tracking whether the directive starts a line.
+    while (sourceBuffer != start && isWhitespace(sourceBuffer[-1]))
+        sourceBuffer--;
+
+    text = string_view(start, size_t(sourceBuffer - start));
+    location = SourceLocation(bufferId, uint32_t(start - originalBegin));
+    if (!text.empty())
+        onNewLine = false;
+    return true;
+}
+
+void Lexer::checkEncoding() {
+    // Non-ASCII characters are only errors outside of comments and string literals,
+    // which the lexer reports as it goes, but text that isn't UTF-8 at all gets a
+    // warning up front. Once is enough to point out a file with the wrong encoding.
+    auto offset = SourceManager::findInvalidEncoding(
+        string_view(sourceBuffer, size_t(sourceEnd - sourceBuffer)));
+    if (offset)
+        addDiag(DiagCode::InvalidSourceEncoding, currentOffset() + *offset);
+}
+
 void Lexer::addTrivia(TriviaKind kind, SmallVector<Trivia>& triviaBuffer) {
     triviaBuffer.emplace(kind, lexeme());
 }
@@ -69,10 +69,25 @@ Preprocessor::Preprocessor(SourceManager& sourceManager, BumpAllocator& alloc,
                            Diagnostics& diagnostics, const Bag& options_) :
     sourceManager(sourceManager),
     alloc(alloc), diagnostics(diagnostics), options(options_.getOrDefault<PreprocessorOptions>()),
-    lexerOptions(options_.getOrDefault<LexerOptions>()) {
-    keywordVersionStack.push_back(getDefaultKeywordVersion());
-    resetAllDirectives();
-    undefineAll();
+    lexerOptions(options_.getOrDefault<LexerOptions>()), includeLexerOptions(lexerOptions) {
+    if (!includeLexerOptions.tokenCache)
+        includeLexerOptions.tokenCache = options.includeTokenCache;
+
+    if (options.snapshot) {
+        macros = options.snapshot->macros;
+        keywordVersionStack = options.snapshot->keywordVersionStack;
+        activeTimescale = options.snapshot->timescale;
+        defaultNetType = options.snapshot->defaultNetType;
+
+        snapshotText = options.snapshot->retainedText;
+        if (snapshotText)
+            sourceBuffers = snapshotText->buffers;
+    }
+    else {
+        keywordVersionStack.push_back(getDefaultKeywordVersion());
+        resetAllDirectives();
+        undefineAll();
+    }
 
     for (std::string& predef : options.predefines) {
         // Find location of equals sign to indicate start of body.
@@ -89,17 +104,40 @@ Preprocessor::Preprocessor(SourceManager& sourceManager, BumpAllocator& alloc,
         undefine(string_view(undef));
 }
 
+Preprocessor::~Preprocessor() {
+    for (auto lexer : lexerStack)
+        lexer->~Lexer();
+}
+
 void Preprocessor::pushSource(string_view source) {
     auto buffer = sourceManager.assignText(source);
     pushSource(buffer);
 }
 
 void Preprocessor::pushSource(SourceBuffer buffer) {
+    pushSource(buffer, lexerOptions);
+}
+
+void Preprocessor::pushSource(SourceBuffer buffer, LexerOptions lexerOpts) {
     ASSERT(lexerStack.size() < options.maxIncludeDepth);
     ASSERT(buffer.id);
 
-    auto lexer = alloc.emplace<Lexer>(buffer, alloc, diagnostics, lexerOptions);
-    lexerStack.push_back(lexer);
+    // Check the encoding ourselves rather than in each lexer, so that files that get
+    // included many times are only scanned, and only warned about, once.
+    if (encodingChecked.insert(buffer.data.data()).second) {
+        if (auto offset = sourceManager.getInvalidEncodingOffset(buffer.id))
+            addDiag(DiagCode::InvalidSourceEncoding, SourceLocation(buffer.id, *offset));
+    }
+
+    lexerOpts.checkEncoding = false;
+
+    // Lexers live in our allocator but aren't trivially destructible, so they
+    // get destroyed explicitly when they're popped (or when we are).
+    auto lexer = new (alloc.allocate(sizeof(Lexer), alignof(Lexer)))
+        Lexer(buffer, alloc, diagnostics, lexerOpts);
+    lexerStack.append(lexer);
+    includeGuardStack.emplace(buffer.data.data());
+    sourceBuffers.push_back(buffer.id);
 }
 
 void Preprocessor::predefine(string_view definition, string_view fileName) {
@@ -124,7 +162,7 @@ void Preprocessor::predefine(string_view definition, string_view fileName) {
 }
 
 bool Preprocessor::undefine(string_view name) {
-    auto it = macros.find(name);
+    auto it = macros.find(IdentifierTable::find(name));
     if (it != macros.end() && !it->second.isIntrinsic()) {
         macros.erase(it);
         return true;
@@ -134,12 +172,50 @@ bool Preprocessor::undefine(string_view name) {
 
 void Preprocessor::undefineAll() {
     macros.clear();
-    macros["__FILE__"] = MacroIntrinsic::File;
-    macros["__LINE__"] = MacroIntrinsic::Line;
+    macros[IdentifierTable::intern("__FILE__")] = MacroIntrinsic::File;
+    macros[IdentifierTable::intern("__LINE__")] = MacroIntrinsic::Line;
 }
 
 bool Preprocessor::isDefined(string_view name) {
-    return !name.empty() && macros.find(name) != macros.end();
+    return !name.empty() && macros.find(IdentifierTable::find(name)) != macros.end();
+}
+
+PreprocessorSnapshot Preprocessor::snapshot() const {
+    // Macros can come from any buffer we've seen, including those of the snapshot
+    // we started from.
+    PreprocessorSnapshot result;
+    result.retainedText = std::make_shared<RetainedText>(sourceManager, sourceBuffers);
+    result.macros = macros;
+    result.keywordVersionStack = keywordVersionStack;
+    result.timescale = activeTimescale;
+    result.defaultNetType = defaultNetType;
+    return result;
+}
+
+Preprocessor::RetainedText::RetainedText(SourceManager& sourceManager,
+                                         std::vector<BufferID> buffers) :
+    sourceManager(sourceManager),
+    buffers(std::move(buffers)) {
+    for (BufferID buffer : this->buffers)
+        sourceManager.retainText(buffer);
+}
+
+Preprocessor::RetainedText::~RetainedText() {
+    for (BufferID buffer : buffers)
+        sourceManager.releaseText(buffer);
+}
+
+bool PreprocessorSnapshot::isDefined(string_view name) const {
+    return !name.empty() && macros.find(IdentifierTable::find(name)) != macros.end();
+}
+
+size_t PreprocessorSnapshot::getMacroCount() const {
+    size_t count = 0;
+    for (auto& [name, def] : macros) {
+        if (!def.isIntrinsic())
+            count++;
+    }
+    return count;
 }
 
 void Preprocessor::setKeywordVersion(KeywordVersion version) {
@@ -262,6 +338,12 @@ Token Preprocessor::handleDirectives(Token token) {
                         trivia.append(createSimpleDirective(token));
                         break;
                 }
+
+                // Text skipped by an inactive branch goes right after its directive.
+                if (!disabledText.empty()) {
+                    trivia.appendRange(disabledText);
+                    disabledText.clear();
+                }
                 break;
             default:
                 trivia.appendRange(token.trivia());
@@ -293,14 +375,13 @@ Token Preprocessor::nextRaw() {
 
     // Pull the next token from the active source.
     // This is the common case.
-    auto& source = lexerStack.back();
-    auto token = source->lex(keywordVersionStack.back());
+    auto token = lexSource();
     if (token.kind != TokenKind::EndOfFile)
         return token;
 
     // don't return EndOfFile tokens for included files, fall
     // through to loop to merge trivia
-    lexerStack.pop_back();
+    popSource();
     if (lexerStack.empty())
         return token;
 
@@ -308,6 +389,13 @@ Token Preprocessor::nextRaw() {
     // that one, but we do want to merge its trivia with whatever comes next.
     SmallVectorSized<Trivia, 16> trivia;
     auto appendTrivia = [&trivia, this](Token token) {
+        // Explicit locations only matter for printing, so don't bother
+        // allocating them if we aren't preserving trivia anyway.
+        if (!lexerOptions.preserveTrivia) {
+            trivia.appendRange(token.trivia());
+            return;
+        }
+
         SourceLocation loc = token.location();
         for (const auto& t : token.trivia())
             trivia.append(t.withLocation(alloc, loc));
@@ -316,13 +404,12 @@ Token Preprocessor::nextRaw() {
     appendTrivia(token);
 
     while (true) {
-        auto& nextSource = lexerStack.back();
-        token = nextSource->lex(keywordVersionStack.back());
+        token = lexSource();
         appendTrivia(token);
         if (token.kind != TokenKind::EndOfFile)
             break;
 
-        lexerStack.pop_back();
+        popSource();
         if (lexerStack.empty())
             break;
     }
@@ -331,6 +418,42 @@ Token Preprocessor::nextRaw() {
     return token.withTrivia(alloc, trivia.copy(alloc));
 }
 
+Token Preprocessor::lexSource() {
+    auto token = lexerStack.back()->lex(keywordVersionStack.back());
+
+    // Anything other than trivia outside of the guard block means the file isn't guarded.
+    // Tokens from inside the block don't matter.
+    auto& guard = includeGuardStack.back();
+    switch (guard.state) {
+        case IncludeGuardEntry::State::Start:
+            if (token.kind == TokenKind::Directive &&
+                token.directiveKind() == SyntaxKind::IfNDefDirective) {
+                guard.state = IncludeGuardEntry::State::ExpectMacro;
+            }
+            else {
+                guard.state = IncludeGuardEntry::State::NotGuarded;
+            }
+            break;
+        case IncludeGuardEntry::State::AfterEndIf:
+            if (token.kind != TokenKind::EndOfFile)
+                guard.state = IncludeGuardEntry::State::NotGuarded;
+            break;
+        default:
+            break;
+    }
+    return token;
+}
+
+void Preprocessor::popSource() {
+    auto& guard = includeGuardStack.back();
+    if (guard.state == IncludeGuardEntry::State::AfterEndIf)
+        includeGuards[guard.text] = guard.macro;
+
+    lexerStack.back()->~Lexer();
+    lexerStack.pop();
+    includeGuardStack.pop();
+}
+
 Trivia Preprocessor::handleIncludeDirective(Token directive) {
     // A (valid) macro-expanded include filename will be lexed as either
     // a StringLiteral or the token sequence '<' ... '>'
@@ -403,8 +526,13 @@ Trivia Preprocessor::handleIncludeDirective(Token directive) {
             addDiag(DiagCode::CouldNotOpenIncludeFile, fileName.location());
         else if (lexerStack.size() >= options.maxIncludeDepth)
             addDiag(DiagCode::ExceededMaxIncludeDepth, fileName.location());
-        else
-            pushSource(buffer);
+        else {
+            // If the file has an include guard that's already defined, including it
+            // again wouldn't produce anything, so don't bother lexing it.
+            auto guard = includeGuards.find(buffer.data.data());
+            if (guard == includeGuards.end() || macros.find(guard->second) == macros.end())
+                pushSource(buffer, includeLexerOptions);
+        }
     }
 
     auto syntax = alloc.emplace<IncludeDirectiveSyntax>(directive, fileName);
@@ -496,7 +624,7 @@ Trivia Preprocessor::handleDefineDirective(Token directive) {
                                                        scratchTokenBuffer.copy(alloc));
 
     if (noErrors)
-        macros[name.valueText()] = result;
+        macros[name.identifierId()] = result;
     return Trivia(TriviaKind::Directive, result);
 }
 
@@ -516,12 +644,27 @@ Trivia Preprocessor::handleIfDefDirective(Token directive, bool inverted) {
     bool take = false;
     if (branchStack.empty() || branchStack.back().currentActive) {
         // decide whether the branch is taken or skipped
-        take = macros.find(name.valueText()) != macros.end();
+        take = macros.find(name.identifierId()) != macros.end();
         if (inverted)
             take = !take;
     }
 
-    branchStack.emplace_back(BranchEntry(take));
+    branchStack.emplace(take);
+
+    // This might be the start of the file's include guard.
+    if (!includeGuardStack.empty()) {
+        auto& guard = includeGuardStack.back();
+        if (guard.state == IncludeGuardEntry::State::ExpectMacro) {
+            if (inverted && name.kind == TokenKind::Identifier && !name.isMissing()) {
+                guard.state = IncludeGuardEntry::State::InGuard;
+                guard.macro = name.identifierId();
+                guard.branchDepth = branchStack.size();
+            }
+            else {
+                guard.state = IncludeGuardEntry::State::NotGuarded;
+            }
+        }
+    }
 
     return parseBranchDirective(directive, name, take);
 }
@@ -529,17 +672,19 @@ Trivia Preprocessor::handleIfDefDirective(Token directive, bool inverted) {
 Trivia Preprocessor::handleElsIfDirective(Token directive) {
     // next token should be the macro name
     auto name = expect(TokenKind::Identifier);
-    bool take = shouldTakeElseBranch(directive.location(), true, name.valueText());
+    bool take = shouldTakeElseBranch(directive.location(), true, name.identifierId());
+    checkIncludeGuardBranch(false);
     return parseBranchDirective(directive, name, take);
 }
 
 Trivia Preprocessor::handleElseDirective(Token directive) {
-    bool take = shouldTakeElseBranch(directive.location(), false, "");
+    bool take = shouldTakeElseBranch(directive.location(), false, IdentifierId::Invalid);
+    checkIncludeGuardBranch(false);
     return parseBranchDirective(directive, Token(), take);
 }
 
 bool Preprocessor::shouldTakeElseBranch(SourceLocation location, bool isElseIf,
-                                        string_view macroName) {
+                                        IdentifierId macroName) {
     // empty stack is an error
     if (branchStack.empty()) {
         addDiag(DiagCode::UnexpectedConditionalDirective, location);
@@ -570,7 +715,7 @@ bool Preprocessor::shouldTakeElseBranch(SourceLocation location, bool isElseIf,
 
 Trivia Preprocessor::parseBranchDirective(Token directive, Token condition, bool taken) {
     scratchTokenBuffer.clear();
-    if (!taken) {
+    if (!taken && !skipDisabledText()) {
         // skip over everything until we find another conditional compilation directive
         while (true) {
             auto token = nextRaw();
@@ -614,13 +759,68 @@ Trivia Preprocessor::parseBranchDirective(Token directive, Token condition, bool
     return Trivia(TriviaKind::Directive, syntax);
 }
 
+bool Preprocessor::skipDisabledText() {
+    // Inactive text can be skipped without lexing it only when it's coming straight
+    // from a source file; tokens that are buffered or come from a macro expansion
+    // have to be looked at one by one.
+    if (currentToken || currentMacroToken || lexerStack.empty())
+        return false;
+
+    while (true) {
+        string_view text;
+        SourceLocation location;
+        if (!lexerStack.back()->skipDisabledText(text, location)) {
+            // Files only continue to be skipped in the files that include them, which
+            // never use a token cache unless the included file does as well, so this
+            // can only happen for the first one.
+            ASSERT(disabledText.empty());
+            return false;
+        }
+
+        if (!text.empty()) {
+            Trivia trivia(TriviaKind::DisabledText, text);
+            if (lexerOptions.preserveTrivia)
+                trivia = trivia.withLocation(alloc, location);
+            disabledText.append(trivia);
+        }
+
+        // The next token is either the directive that ends the block or the end of the
+        // file. If an include file ends while the block is still going, keep skipping
+        // in the file that included it.
+        auto token = lexSource();
+        if (token.kind == TokenKind::EndOfFile && lexerStack.size() > 1) {
+            popSource();
+            continue;
+        }
+
+        currentToken = token;
+        return true;
+    }
+}
+
+void Preprocessor::checkIncludeGuardBranch(bool isEndIf) {
+    // An `else or `elsif for the guard block means some of the file is active even when
+    // the guard macro is defined, so it can't be skipped. An `endif closes the block.
+    if (includeGuardStack.empty())
+        return;
+
+    auto& guard = includeGuardStack.back();
+    if (guard.state == IncludeGuardEntry::State::InGuard &&
+        branchStack.size() == guard.branchDepth) {
+        guard.state = isEndIf ? IncludeGuardEntry::State::AfterEndIf
+                              : IncludeGuardEntry::State::NotGuarded;
+    }
+}
+
 Trivia Preprocessor::handleEndIfDirective(Token directive) {
+    checkIncludeGuardBranch(true);
+
     // pop the active branch off the stack
     bool taken = true;
     if (branchStack.empty())
         addDiag(DiagCode::UnexpectedConditionalDirective, directive.location());
     else {
-        branchStack.pop_back();
+        branchStack.pop();
         if (!branchStack.empty() && !branchStack.back().currentActive)
             taken = false;
     }
@@ -658,7 +858,8 @@ bool Preprocessor::expectTimescaleSpecifier(Token& value, Token& unit,
                                        token.location() + numText.length(), token.getInfo()->flags);
 
         unit = Token(TokenKind::Identifier, unitInfo);
-        unitInfo->extra = IdentifierType::Normal;
+        unitInfo->extra.idType = IdentifierType::Normal;
+        unitInfo->identifierId = IdentifierTable::intern(timeUnitSuffix);
 
         consume();
         if (!success)
@@ -771,7 +972,7 @@ Trivia Preprocessor::handleUndefDirective(Token directive) {
     // TODO: additional checks for undefining other builtin directives
     if (!nameToken.isMissing()) {
         string_view name = nameToken.valueText();
-        auto it = macros.find(name);
+        auto it = macros.find(nameToken.identifierId());
         if (it != macros.end()) {
             if (name != "__LINE__" && name != "__FILE__")
                 macros.erase(it);
@@ -818,14 +1019,103 @@ Trivia Preprocessor::createSimpleDirective(Token directive) {
 }
 
 Preprocessor::MacroDef Preprocessor::findMacro(Token directive) {
-    string_view name = directive.valueText().substr(1);
-    if (!name.empty() && name[0] == '\\')
-        name = name.substr(1);
+    auto it = macros.find(directive.identifierId());
+    MacroDef result = it == macros.end() ? MacroDef() : it->second;
 
-    auto it = macros.find(name);
-    if (it == macros.end())
-        return nullptr;
-    return it->second;
+    if (memoRecorder) {
+        if (result.isIntrinsic())
+            memoRecorder->usedIntrinsic = true;
+        memoRecorder->dependencies.emplace(directive.identifierId(), result.syntax);
+    }
+    return result;
+}
+
+SourceLocation Preprocessor::createExpansionLoc(SourceLocation originalLoc, SourceLocation start,
+                                                SourceLocation end, string_view macroName,
+                                                bool isMacroArg) {
+    SourceLocation result = isMacroArg
+                                ? sourceManager.createExpansionLoc(originalLoc, start, end, true)
+                                : sourceManager.createExpansionLoc(originalLoc, start, end,
+                                                                   macroName);
+    if (memoRecorder)
+        memoRecorder->expansions.append({ result, originalLoc, start, end, macroName, isMacroArg });
+    return result;
+}
+
+bool Preprocessor::replayMemo(const MacroMemo& memo, Token directive) {
+    if (memo.keywordVersion != keywordVersionStack.back())
+        return false;
+
+    for (auto& [name, syntax] : memo.dependencies) {
+        auto it = macros.find(name);
+        if ((it == macros.end() ? nullptr : it->second.syntax) != syntax)
+            return false;
+    }
+
+    SmallVectorSized<SourceLocation, 8> expansionLocs;
+    auto resolve = [&](const MemoLocation& loc) {
+        if (loc.expansion == MemoLocation::Fixed)
+            return loc.location;
+        return expansionLocs[loc.expansion] + loc.offset;
+    };
+
+    // The first expansion is for the macro itself, so its range is the usage site.
+    SourceRange range{ directive.location(),
+                       directive.location() + directive.rawText().length() };
+    for (auto& expansion : memo.expansions) {
+        SourceLocation start = expansionLocs.empty() ? range.start() : resolve(expansion.start);
+        SourceLocation end = expansionLocs.empty() ? range.end() : resolve(expansion.end);
+        SourceLocation original = resolve(expansion.original);
+        expansionLocs.append(expansion.isMacroArg
+                                 ? sourceManager.createExpansionLoc(original, start, end, true)
+                                 : sourceManager.createExpansionLoc(original, start, end,
+                                                                    expansion.macroName));
+    }
+
+    expandedTokens.clear();
+    auto location = memo.locations.begin();
+    for (auto& token : memo.tokens)
+        expandedTokens.append(token.withLocation(alloc, resolve(*location++)));
+
+    return true;
+}
+
+void Preprocessor::storeMemo(DefineDirectiveSyntax* macro, const MemoRecorder& recorder) {
+    // The expansion of the macro itself always comes first; without it there is
+    // nothing to relocate the tokens against.
+    if (recorder.usedIntrinsic || recorder.usedSourceTokens || recorder.expansions.empty())
+        return;
+
+    // Locations inside any of the expansions created along the way need to be made
+    // relative to them; anything else, like the macro definitions, stays fixed.
+    auto makeRelative = [&](SourceLocation loc, size_t limit) {
+        for (size_t i = 0; i < limit; i++) {
+            SourceLocation base = recorder.expansions[i].result;
+            if (loc.buffer() == base.buffer())
+                return MemoLocation{ {}, uint32_t(i), loc.offset() - base.offset() };
+        }
+        return MemoLocation{ loc };
+    };
+
+    SmallVectorSized<MemoExpansionLoc, 8> expansions;
+    for (size_t i = 0; i < recorder.expansions.size(); i++) {
+        auto& expansion = recorder.expansions[i];
+        expansions.append({ makeRelative(expansion.original, i), makeRelative(expansion.start, i),
+                            makeRelative(expansion.end, i), expansion.macroName,
+                            expansion.isMacroArg });
+    }
+
+    SmallVectorSized<MemoLocation, 16> locations;
+    for (auto& token : expandedTokens)
+        locations.append(makeRelative(token.location(), recorder.expansions.size()));
+
+    MacroMemo memo;
+    memo.expansions = expansions.copy(alloc);
+    memo.tokens = expandedTokens.copy(alloc);
+    memo.locations = locations.copy(alloc);
+    memo.dependencies = recorder.dependencies.copy(alloc);
+    memo.keywordVersion = keywordVersionStack.back();
+    macroMemos[macro] = memo;
 }
 
 MacroActualArgumentListSyntax* Preprocessor::handleTopLevelMacro(Token directive) {
@@ -851,11 +1141,28 @@ MacroActualArgumentListSyntax* Preprocessor::handleTopLevelMacro(Token directive
             return nullptr;
     }
 
+    // Object-like macros expand the same way every time, so if we've seen this one
+    // before and the macros it depends on haven't changed we can reuse that expansion.
+    MemoRecorder recorder;
+    size_t diagCount = diagnostics.size();
+    bool memoize = !macro.isIntrinsic() && !macro.syntax->formalArguments;
+    if (memoize) {
+        auto it = macroMemos.find(macro.syntax);
+        if (it != macroMemos.end() && replayMemo(it->second, directive)) {
+            if (!expandedTokens.empty())
+                currentMacroToken = expandedTokens.begin();
+            return nullptr;
+        }
+        memoRecorder = &recorder;
+    }
+
     // Expand out the macro
     SmallVectorSized<Token, 32> buffer;
     MacroExpansion expansion{ alloc, buffer, directive, true };
-    if (!expandMacro(macro, expansion, actualArgs))
+    if (!expandMacro(macro, expansion, actualArgs)) {
+        memoRecorder = nullptr;
         return actualArgs;
+    }
 
     // The macro is now expanded out into tokens, but some of those tokens might
     // be more macros that need to be expanded, or special characters that
@@ -869,8 +1176,10 @@ MacroActualArgumentListSyntax* Preprocessor::handleTopLevelMacro(Token directive
     span<Token const> tokens = buffer.copy(alloc);
     while (true) {
         // Start by recursively expanding out all valid macro usages.
-        if (!expandReplacementList(tokens, alreadyExpanded))
+        if (!expandReplacementList(tokens, alreadyExpanded)) {
+            memoRecorder = nullptr;
             return actualArgs;
+        }
 
         // Now that all macros have been expanded, handle token concatenation and stringification.
         expandedTokens.clear();
@@ -880,6 +1189,11 @@ MacroActualArgumentListSyntax* Preprocessor::handleTopLevelMacro(Token directive
         tokens = expandedTokens;
     }
 
+    // Only clean expansions get memoized; otherwise replaying would lose the diagnostics.
+    memoRecorder = nullptr;
+    if (memoize && diagnostics.size() == diagCount)
+        storeMemo(macro.syntax, recorder);
+
     // if the macro expanded into any tokens at all, set the pointer
     // so that we'll pull from them next
     if (!expandedTokens.empty())
@@ -986,7 +1300,8 @@ bool Preprocessor::applyMacroOps(span<Token const> tokens, SmallVector<Token>& d
             if (offset != std::string_view::npos) {
                 // Split the token, finish the stringification.
                 auto splitInfo = alloc.emplace<Token::Info>(*newToken.getInfo());
-                splitInfo->rawText = splitInfo->rawText.substr(0, offset);
+                splitInfo->setRawText(splitInfo->rawText().substr(0, offset));
+                splitInfo->identifierId = IdentifierTable::intern(splitInfo->rawText().substr(1));
                 stringifyBuffer.append(Token(TokenKind::Identifier, splitInfo));
 
                 dest.append(Lexer::stringify(alloc, stringify.location(), stringify.trivia(),
@@ -1031,8 +1346,8 @@ bool Preprocessor::expandMacro(MacroDef macro, MacroExpansion& expansion,
     if (!directive->formalArguments) {
         // each macro expansion gets its own location entry
         SourceLocation start = body[0].location();
-        SourceLocation expansionLoc = sourceManager.createExpansionLoc(
-            start, expansion.getRange().start(), expansion.getRange().end(), macroName);
+        SourceLocation expansionLoc = createExpansionLoc(
+            start, expansion.getRange().start(), expansion.getRange().end(), macroName, false);
 
         // simple macro; just take body tokens
         for (auto token : body)
@@ -1055,12 +1370,20 @@ bool Preprocessor::expandMacro(MacroDef macro, MacroExpansion& expansion,
         using span<const Token>::operator=;
         bool isExpanded = false;
     };
-    SmallMap<string_view, ArgTokens, 8> argumentMap;
+    SmallMap<IdentifierId, ArgTokens, 8> argumentMap;
 
+    // Arguments are matched by interned name. Keywords can be used as argument names too,
+    // but the lexer doesn't intern those, so they need to be looked up by their text.
+    bool anyKeywordArgs = false;
     for (uint32_t i = 0; i < formalList.size(); i++) {
         auto formal = formalList[i];
-        auto name = formal->name.valueText();
-        if (name.empty())
+        IdentifierId name = formal->name.identifierId();
+        if (name == IdentifierId::Invalid && isKeyword(formal->name.kind)) {
+            name = IdentifierTable::intern(formal->name.valueText());
+            anyKeywordArgs = true;
+        }
+
+        if (name == IdentifierId::Invalid)
             continue;
 
         const TokenList* tokenList = nullptr;
@@ -1085,9 +1408,9 @@ bool Preprocessor::expandMacro(MacroDef macro, MacroExpansion& expansion,
 
     Token endOfArgs = actualArgs->getLastToken();
     SourceLocation start = body[0].location();
-    SourceLocation expansionLoc = sourceManager.createExpansionLoc(
+    SourceLocation expansionLoc = createExpansionLoc(
         start, expansion.getRange().start(), endOfArgs.location() + endOfArgs.rawText().length(),
-        macroName);
+        macroName, false);
 
     // now add each body token, substituting arguments as necessary
     for (auto& token : body) {
@@ -1105,12 +1428,14 @@ bool Preprocessor::expandMacro(MacroDef macro, MacroExpansion& expansion,
         // `define FOO(bar) `bar
         // `define ONE 1
         // `FOO(ONE)   // expands to 1
-        string_view text = token.valueText();
-        if (token.kind == TokenKind::Directive && text.length() >= 1)
-            text = text.substr(1);
+        IdentifierId name;
+        if (token.kind == TokenKind::Identifier || token.kind == TokenKind::Directive)
+            name = token.identifierId();
+        else
+            name = anyKeywordArgs ? IdentifierTable::find(token.valueText()) : IdentifierId::Invalid;
 
         // check for formal param
-        auto it = argumentMap.find(text);
+        auto it = argumentMap.find(name);
         if (it == argumentMap.end()) {
             expansion.append(token, location);
             continue;
@@ -1148,8 +1473,8 @@ bool Preprocessor::expandMacro(MacroDef macro, MacroExpansion& expansion,
         // Arguments need their own expansion location created; the original
         // location comes from the source file itself, and the expansion location
         // points into the macro body where the formal argument was used.
-        SourceLocation argLoc = sourceManager.createExpansionLoc(
-            firstLoc, location, location + token.rawText().length(), true);
+        SourceLocation argLoc = createExpansionLoc(firstLoc, location,
+                                                   location + token.rawText().length(), {}, true);
 
         // See note above about weird macro usage being argument replaced.
         // In that case we want to fabricate the correct directive token here.
@@ -1167,8 +1492,8 @@ bool Preprocessor::expandMacro(MacroDef macro, MacroExpansion& expansion,
             // the new buffer as its original location.
             if (begin->location().buffer() != firstLoc.buffer()) {
                 firstLoc = begin->location();
-                argLoc = sourceManager.createExpansionLoc(
-                    firstLoc, location, location + token.rawText().length(), true);
+                argLoc = createExpansionLoc(firstLoc, location,
+                                            location + token.rawText().length(), {}, true);
             }
             expansion.append(*begin, argLoc + (begin->location() - firstLoc));
         }
@@ -1288,8 +1613,8 @@ bool Preprocessor::expandIntrinsic(MacroIntrinsic intrinsic, MacroExpansion& exp
         case MacroIntrinsic::File: {
             string_view fileName = sourceManager.getFileName(loc);
             text.appendRange(fileName);
-            info->extra = fileName;
-            info->rawText = to_string_view(text.copy(alloc));
+            info->setStringText(alloc, fileName);
+            info->setRawText(to_string_view(text.copy(alloc)));
 
             expansion.append(Token(TokenKind::StringLiteral, info), loc);
             break;
@@ -1298,7 +1623,7 @@ bool Preprocessor::expandIntrinsic(MacroIntrinsic intrinsic, MacroExpansion& exp
             uint32_t lineNum = sourceManager.getLineNumber(loc);
             text.appendRange(std::to_string(lineNum)); // not the most efficient, but whatever
             info->setInt(alloc, lineNum);
-            info->rawText = to_string_view(text.copy(alloc));
+            info->setRawText(to_string_view(text.copy(alloc)));
 
             expansion.append(Token(TokenKind::IntegerLiteral, info), loc);
             break;
@@ -1459,6 +1784,8 @@ Token Preprocessor::MacroParser::next() {
 Token Preprocessor::MacroParser::peek() {
     if (currentIndex < buffer.size())
         return buffer[currentIndex];
+
+    markSourceTokensUsed();
     return pp.peek();
 }
 
@@ -1466,12 +1793,16 @@ Token Preprocessor::MacroParser::consume() {
     auto result = next();
     if (result)
         return result;
+
+    markSourceTokensUsed();
     return pp.consume();
 }
 
 Token Preprocessor::MacroParser::expect(TokenKind kind) {
-    if (currentIndex >= buffer.size())
+    if (currentIndex >= buffer.size()) {
+        markSourceTokensUsed();
         return pp.expect(kind);
+    }
 
     if (buffer[currentIndex].kind != kind) {
         Token last = currentIndex > 0 ? buffer[currentIndex - 1] : Token();
@@ -1480,4 +1811,11 @@ Token Preprocessor::MacroParser::expect(TokenKind kind) {
     return next();
 }
 
+void Preprocessor::MacroParser::markSourceTokensUsed() {
+    // Whatever follows the usage site can differ from one usage to the next,
+    // so an expansion that looks at it can't be memoized.
+    if (pp.memoRecorder)
+        pp.memoRecorder->usedSourceTokens = true;
+}
+
 } // namespace slang
@@ -98,72 +98,37 @@ span<Token const> Trivia::getSkippedTokens() const {
 
 Token::Info::Info(span<Trivia const> trivia, string_view rawText, SourceLocation location,
                   bitmask<TokenFlags> flags) :
-    trivia(trivia),
-    rawText(rawText), location(location), flags(flags) {
+    location(location),
+    flags(flags) {
+    setTrivia(trivia);
+    setRawText(rawText);
 }
 
-void Token::Info::setBit(logic_t value) {
-    NumericLiteralInfo* target = std::get_if<NumericLiteralInfo>(&extra);
-    if (target)
-        target->value = value;
-    else {
-        NumericLiteralInfo numInfo;
-        numInfo.value = value;
-        extra = numInfo;
-    }
+void Token::Info::setTrivia(span<Trivia const> trivia) {
+    triviaPtr = trivia.data();
+    triviaCount = (uint32_t)trivia.size();
 }
 
-void Token::Info::setReal(double value) {
-    NumericLiteralInfo* target = std::get_if<NumericLiteralInfo>(&extra);
-    if (target)
-        target->value = value;
-    else {
-        NumericLiteralInfo numInfo;
-        numInfo.value = value;
-        extra = numInfo;
-    }
+void Token::Info::setRawText(string_view text) {
+    rawTextPtr = text.data();
+    rawTextLength = (uint32_t)text.length();
 }
 
 void Token::Info::setInt(BumpAllocator& alloc, const SVInt& value) {
-    SVIntStorage storage(value.getBitWidth(), value.isSigned(), value.hasUnknown());
+    auto storage =
+        alloc.emplace<SVIntStorage>(value.getBitWidth(), value.isSigned(), value.hasUnknown());
     if (value.isSingleWord())
-        storage.val = *value.getRawData();
+        storage->val = *value.getRawData();
     else {
-        storage.pVal =
+        storage->pVal =
             (uint64_t*)alloc.allocate(sizeof(uint64_t) * value.getNumWords(), alignof(uint64_t));
-        memcpy(storage.pVal, value.getRawData(), sizeof(uint64_t) * value.getNumWords());
-    }
-
-    NumericLiteralInfo* target = std::get_if<NumericLiteralInfo>(&extra);
-    if (target)
-        target->value = storage;
-    else {
-        NumericLiteralInfo numInfo;
-        numInfo.value = storage;
-        extra = numInfo;
-    }
-}
-
-void Token::Info::setNumFlags(LiteralBase base, bool isSigned) {
-    NumericLiteralInfo* target = std::get_if<NumericLiteralInfo>(&extra);
-    if (target)
-        target->numericFlags.set(base, isSigned);
-    else {
-        NumericLiteralInfo numInfo;
-        numInfo.numericFlags.set(base, isSigned);
-        extra = numInfo;
+        memcpy(storage->pVal, value.getRawData(), sizeof(uint64_t) * value.getNumWords());
     }
+    extra.integer = storage;
 }
 
-void Token::Info::setTimeUnit(TimeUnit unit) {
-    NumericLiteralInfo* target = std::get_if<NumericLiteralInfo>(&extra);
-    if (target)
-        target->numericFlags.set(unit);
-    else {
-        NumericLiteralInfo numInfo;
-        numInfo.numericFlags.set(unit);
-        extra = numInfo;
-    }
+void Token::Info::setStringText(BumpAllocator& alloc, string_view text) {
+    extra.stringText = text.empty() ? nullptr : alloc.emplace<string_view>(text);
 }
 
 Token::Token() : kind(TokenKind::Unknown), info(nullptr) {
@@ -179,10 +144,10 @@ string_view Token::valueText() const {
             switch (identifierType()) {
                 case IdentifierType::Normal:
                 case IdentifierType::System:
-                    return info->rawText;
+                    return info->rawText();
                 case IdentifierType::Escaped:
                     // strip off leading backslash
-                    return info->rawText.substr(1);
+                    return info->rawText().substr(1);
                 case IdentifierType::Unknown:
                     // unknown tokens don't have value text
                     return "";
@@ -193,7 +158,7 @@ string_view Token::valueText() const {
         case TokenKind::IncludeFileName:
         case TokenKind::Directive:
         case TokenKind::MacroUsage:
-            return info->rawText;
+            return info->rawText();
         default:
             return getTokenKindText(kind);
     }
@@ -220,7 +185,7 @@ string_view Token::rawText() const {
             case TokenKind::MacroUsage:
             case TokenKind::EmptyMacroArgument:
             case TokenKind::LineContinuation:
-                return info->rawText;
+                return info->rawText();
             case TokenKind::EndOfFile:
                 return "";
             default:
@@ -239,38 +204,57 @@ std::string Token::toString() const {
 
 SVInt Token::intValue() const {
     ASSERT(kind == TokenKind::IntegerLiteral);
-    return std::get<SVIntStorage>(info->numInfo().value);
+    return *info->extra.integer;
 }
 
 double Token::realValue() const {
     ASSERT(kind == TokenKind::RealLiteral || kind == TokenKind::TimeLiteral);
-    return std::get<double>(info->numInfo().value);
+    return info->extra.real;
 }
 
 logic_t Token::bitValue() const {
     ASSERT(kind == TokenKind::UnbasedUnsizedLiteral);
-    return std::get<logic_t>(info->numInfo().value);
+    return logic_t(info->extra.bit);
 }
 
 NumericTokenFlags Token::numericFlags() const {
     ASSERT(kind == TokenKind::IntegerBase || kind == TokenKind::TimeLiteral);
-    return info->numInfo().numericFlags;
+    return info->numFlags;
 }
 
 IdentifierType Token::identifierType() const {
     if (kind == TokenKind::Identifier)
-        return info->idType();
+        return info->extra.idType;
     return IdentifierType::Unknown;
 }
 
+IdentifierId Token::identifierId() const {
+    if (info->identifierId != IdentifierId::Invalid)
+        return info->identifierId;
+
+    // Tokens built by hand (for example, in tests) don't carry an ID; look their
+    // name up without adding anything to the table.
+    if (kind == TokenKind::Identifier)
+        return IdentifierTable::find(valueText());
+
+    if (kind == TokenKind::Directive && info->extra.directiveKind == SyntaxKind::MacroUsage) {
+        string_view name = info->rawText().substr(1);
+        if (!name.empty() && name[0] == '\\')
+            name = name.substr(1);
+        return IdentifierTable::find(name);
+    }
+
+    return IdentifierId::Invalid;
+}
+
 SyntaxKind Token::directiveKind() const {
     ASSERT(kind == TokenKind::Directive || kind == TokenKind::MacroUsage);
-    return info->directiveKind();
+    return info->extra.directiveKind;
 }
 
 Token Token::withTrivia(BumpAllocator& alloc, span<Trivia const> trivia) const {
     auto newInfo = alloc.emplace<Info>(*info);
-    newInfo->trivia = trivia;
+    newInfo->setTrivia(trivia);
     return Token(kind, newInfo);
 }
 
@@ -287,15 +271,15 @@ Token Token::createMissing(BumpAllocator& alloc, TokenKind kind, SourceLocation
 
     switch (kind) {
         case TokenKind::Identifier:
-            info->extra = IdentifierType::Unknown;
+            info->extra.idType = IdentifierType::Unknown;
             break;
         case TokenKind::IncludeFileName:
         case TokenKind::StringLiteral:
-            info->extra = string_view("");
+            info->setStringText(alloc, "");
             break;
         case TokenKind::Directive:
         case TokenKind::MacroUsage:
-            info->extra = SyntaxKind::Unknown;
+            info->extra.directiveKind = SyntaxKind::Unknown;
             break;
         case TokenKind::IntegerLiteral:
             info->setInt(alloc, 0);
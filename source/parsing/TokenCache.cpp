@@ -0,0 +1,621 @@
+//------------------------------------------------------------------------------
+// TokenCache.cpp
+// Cache of lexed token streams.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#include "slang/parsing/TokenCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    define HAS_MMAP 1
+#endif
+
+#include "slang/util/BumpAllocator.h"
+#include "slang/util/Hash.h"
+
+namespace fs = std::filesystem;
+
+namespace slang {
+
+SyntaxKind getDirectiveKind(string_view directive);
+
+namespace {
+
+// The layout of a cache file is a FileHeader, followed by the array of TokenRecords,
+// followed by the array of TriviaRecords, followed by the text of string literals.
+// There's no padding between sections: the header and token records are multiples of
+// 8 bytes in size so the token records are 8 byte aligned, but trivia records are 12
+// bytes so the string section that follows them is only 4 byte aligned (which is fine,
+// since it's just characters).
+constexpr uint32_t FileMagic = 0x43544C53; // "SLTC"
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t formatVersion;
+    uint64_t contentHash;
+    uint32_t contentSize;
+    uint8_t preserveTrivia;
+    uint8_t keywordVersion;
+    uint16_t reserved;
+    uint32_t tokenCount;
+    uint32_t triviaCount;
+    uint32_t stringBytes;
+    uint32_t reserved2;
+};
+static_assert(sizeof(FileHeader) == 40);
+
+struct TokenRecord {
+    // The raw bits of the token's extra data. For string literals this is instead
+    // the offset and length of the value text within the string section, and for
+    // integer literals it's the integer value.
+    uint64_t payload;
+    uint32_t offset;
+    uint32_t length;
+    uint32_t firstTrivia;
+    uint32_t triviaCount;
+    TokenKind kind;
+    uint8_t numFlags;
+    uint8_t keywordVersion;
+
+    // If the token has an interned identifier, the offset within the raw text where
+    // its name begins. Otherwise NoIdentifier.
+    uint8_t identifierStart;
+    uint8_t intWidth;
+    uint8_t intSigned;
+    uint8_t reserved;
+};
+static_assert(sizeof(TokenRecord) == 32);
+
+struct TriviaRecord {
+    // Offset of the trivia text, or CanonicalText if the trivia is a placeholder that
+    // the lexer made up for the token instead of text from the source.
+    uint32_t offset;
+    uint32_t length;
+    TriviaKind kind;
+    uint8_t reserved[3];
+};
+static_assert(sizeof(TriviaRecord) == 12);
+
+constexpr uint8_t NoIdentifier = 0xFF;
+constexpr uint32_t CanonicalText = UINT32_MAX;
+
+// The kinds of trivia the lexer produces, all of which are plain views of the source.
+// Other kinds refer to tokens or syntax nodes and can't be stored in the cache.
+bool isTextTrivia(TriviaKind kind) {
+    switch (kind) {
+        case TriviaKind::Whitespace:
+        case TriviaKind::EndOfLine:
+        case TriviaKind::LineComment:
+        case TriviaKind::BlockComment:
+        case TriviaKind::DisabledText:
+            return true;
+        default:
+            return false;
+    }
+}
+
+string_view getCanonicalText(TriviaKind kind) {
+    return kind == TriviaKind::EndOfLine ? "\n" : " ";
+}
+
+uint64_t makeKey(uint64_t contentHash, size_t contentSize, bool preserveTrivia,
+                 KeywordVersion keywordVersion) {
+    uint64_t fields[] = { contentHash, TokenCache::FormatVersion, uint64_t(contentSize),
+                          uint64_t(preserveTrivia), uint64_t(keywordVersion) };
+    return xxhash64(fields, sizeof(fields), 0);
+}
+
+} // namespace
+
+struct TokenCache::Entry {
+    const FileHeader* header = nullptr;
+    const TokenRecord* tokens = nullptr;
+    const TriviaRecord* trivia = nullptr;
+    const char* strings = nullptr;
+
+    // The interned identifier of each token, or Invalid if it doesn't have one. These
+    // are only meaningful within a single run so they aren't part of the file data;
+    // looking them up once per entry saves interning names every time it's replayed.
+    std::vector<IdentifierId> identifiers;
+
+    // The entry's data is either memory mapped from the cache file, or stored here.
+    std::vector<uint64_t> mem;
+    void* mapped = nullptr;
+    size_t mappedSize = 0;
+
+    Entry() = default;
+    Entry(const Entry&) = delete;
+    Entry& operator=(const Entry&) = delete;
+
+    ~Entry() {
+#if HAS_MMAP
+        if (mapped)
+            ::munmap(mapped, mappedSize);
+#endif
+    }
+
+    // Loads the entry from the given cache file, returning nullptr if it doesn't exist
+    // or doesn't match the arguments.
+    static std::unique_ptr<Entry> load(const fs::path& path, string_view source,
+                                       uint64_t contentHash, bool preserveTrivia,
+                                       KeywordVersion keywordVersion);
+
+    // Points the entry at the given data, checking that it's well formed and that
+    // it describes the given source text, so that replaying it can't produce
+    // tokens that point outside of the text.
+    bool init(const void* data, size_t size, string_view source, uint64_t contentHash,
+              bool preserveTrivia, KeywordVersion keywordVersion);
+    void internIdentifiers(string_view source);
+};
+
+struct TokenCache::Recorder {
+    uint64_t key;
+    uint64_t contentHash;
+    string_view source;
+    bool preserveTrivia;
+    KeywordVersion keywordVersion;
+
+    std::vector<TokenRecord> tokens;
+    std::vector<TriviaRecord> trivia;
+    std::vector<IdentifierId> identifiers;
+    std::string strings;
+};
+
+bool TokenCache::Entry::init(const void* data, size_t size, string_view source,
+                             uint64_t contentHash, bool preserveTrivia,
+                             KeywordVersion keywordVersion) {
+    if (size < sizeof(FileHeader))
+        return false;
+
+    auto hdr = static_cast<const FileHeader*>(data);
+    if (hdr->magic != FileMagic || hdr->formatVersion != FormatVersion ||
+        hdr->contentHash != contentHash || hdr->contentSize != source.size() ||
+        hdr->preserveTrivia != uint8_t(preserveTrivia) ||
+        hdr->keywordVersion != uint8_t(keywordVersion) || hdr->tokenCount == 0) {
+        return false;
+    }
+
+    uint64_t expectedSize = sizeof(FileHeader) + uint64_t(hdr->tokenCount) * sizeof(TokenRecord) +
+                            uint64_t(hdr->triviaCount) * sizeof(TriviaRecord) +
+                            hdr->stringBytes;
+    if (size != expectedSize)
+        return false;
+
+    auto bytes = static_cast<const char*>(data);
+    auto toks = reinterpret_cast<const TokenRecord*>(bytes + sizeof(FileHeader));
+    auto triv = reinterpret_cast<const TriviaRecord*>(toks + hdr->tokenCount);
+    auto strs = reinterpret_cast<const char*>(triv + hdr->triviaCount);
+
+    auto inSource = [&](uint32_t offset, uint32_t length) {
+        return uint64_t(offset) + length <= source.size();
+    };
+
+    // Everything read from the file is checked, including enum values, so that a corrupted
+    // or stale file can't feed the parser tokens that the lexer would never produce.
+    for (uint32_t i = 0; i < hdr->tokenCount; i++) {
+        auto& tok = toks[i];
+        if (tok.kind > TokenKind::LineContinuation || !inSource(tok.offset, tok.length) ||
+            uint64_t(tok.firstTrivia) + tok.triviaCount > hdr->triviaCount ||
+            (tok.identifierStart != NoIdentifier && tok.identifierStart >= tok.length)) {
+            return false;
+        }
+
+        if (tok.kind == TokenKind::StringLiteral &&
+            (tok.payload >> 32) + (tok.payload & UINT32_MAX) > hdr->stringBytes) {
+            return false;
+        }
+
+        if (tok.kind == TokenKind::IntegerLiteral && (tok.intWidth == 0 || tok.intWidth > 64))
+            return false;
+
+        if (tok.kind == TokenKind::Identifier &&
+            uint8_t(tok.payload) > uint8_t(IdentifierType::System)) {
+            return false;
+        }
+
+        if (tok.kind == TokenKind::Directive) {
+            // The directive kind is entirely determined by the text, so make sure they agree.
+            SyntaxKind directiveKind;
+            memcpy(&directiveKind, &tok.payload, sizeof(directiveKind));
+            if (tok.length == 0 ||
+                directiveKind != getDirectiveKind(source.substr(tok.offset + 1, tok.length - 1))) {
+                return false;
+            }
+        }
+    }
+
+    if (toks[hdr->tokenCount - 1].kind != TokenKind::EndOfFile)
+        return false;
+
+    for (uint32_t i = 0; i < hdr->triviaCount; i++) {
+        auto& t = triv[i];
+        if (!isTextTrivia(t.kind))
+            return false;
+
+        if (t.offset == CanonicalText) {
+            if (t.kind != TriviaKind::Whitespace && t.kind != TriviaKind::EndOfLine)
+                return false;
+        }
+        else if (!inSource(t.offset, t.length)) {
+            return false;
+        }
+    }
+
+    header = hdr;
+    tokens = toks;
+    trivia = triv;
+    strings = strs;
+    return true;
+}
+
+void TokenCache::Entry::internIdentifiers(string_view source) {
+    identifiers.resize(header->tokenCount);
+    for (uint32_t i = 0; i < header->tokenCount; i++) {
+        auto& tok = tokens[i];
+        if (tok.identifierStart != NoIdentifier) {
+            identifiers[i] = IdentifierTable::intern(
+                source.substr(tok.offset + tok.identifierStart, tok.length - tok.identifierStart));
+        }
+    }
+}
+
+TokenCache::TokenCache() = default;
+
+TokenCache::TokenCache(string_view directory) : directory(directory) {
+    std::error_code ec;
+    fs::create_directories(fs::path(this->directory), ec);
+}
+
+TokenCache::~TokenCache() = default;
+
+size_t TokenCache::getHitCount() const {
+    std::unique_lock lock(mut);
+    return hits;
+}
+
+size_t TokenCache::getMissCount() const {
+    std::unique_lock lock(mut);
+    return misses;
+}
+
+size_t TokenCache::getRecordingCount() const {
+    std::unique_lock lock(mut);
+    return recorders.size();
+}
+
+static fs::path getEntryPath(const std::string& directory, uint64_t key) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.tokens", (unsigned long long)key);
+    return fs::path(directory) / name;
+}
+
+// Gets a suffix for temporary file names that's unique to the calling thread. Several
+// processes can share a cache directory, so the thread ID alone isn't enough.
+static std::string getTempSuffix() {
+    static const std::string processTag = [] {
+        std::random_device device;
+        std::string tag = std::to_string(device());
+#if HAS_MMAP
+        tag = std::to_string(::getpid()) + "." + tag;
+#endif
+        return tag;
+    }();
+
+    return ".tmp" + processTag + "." +
+           std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+}
+
+const TokenCache::Entry* TokenCache::lookup(string_view source, bool preserveTrivia,
+                                            KeywordVersion keywordVersion, Recorder*& recorder) {
+    uint64_t contentHash = xxhash64(source.data(), source.size(), 0);
+    uint64_t key = makeKey(contentHash, source.size(), preserveTrivia, keywordVersion);
+    {
+        std::unique_lock lock(mut);
+        if (auto it = entries.find(key); it != entries.end()) {
+            hits++;
+            return it->second.get();
+        }
+    }
+
+    // Not seen yet in this run; see if an earlier run left it on disk.
+    std::unique_ptr<Entry> entry;
+    if (!directory.empty()) {
+        entry = Entry::load(getEntryPath(directory, key), source, contentHash, preserveTrivia,
+                            keywordVersion);
+    }
+
+    std::unique_lock lock(mut);
+    if (entry) {
+        hits++;
+        auto [it, inserted] = entries.emplace(key, std::move(entry));
+        return it->second.get();
+    }
+
+    misses++;
+    auto newRecorder = std::make_unique<Recorder>();
+    newRecorder->key = key;
+    newRecorder->contentHash = contentHash;
+    newRecorder->source = source;
+    newRecorder->preserveTrivia = preserveTrivia;
+    newRecorder->keywordVersion = keywordVersion;
+
+    recorder = newRecorder.get();
+    recorders.emplace(recorder, std::move(newRecorder));
+    return nullptr;
+}
+
+bool TokenCache::replay(const Entry& entry, uint32_t index, KeywordVersion keywordVersion,
+                        BufferID bufferId, const char* source, BumpAllocator& alloc,
+                        Token& result, uint32_t& resumeOffset) {
+    // Once the end of the file is reached, keep handing out EndOfFile tokens.
+    index = std::min(index, entry.header->tokenCount - 1);
+    const TokenRecord& rec = entry.tokens[index];
+    if (rec.keywordVersion != uint8_t(keywordVersion)) {
+        if (index == 0) {
+            resumeOffset = 0;
+        }
+        else {
+            const TokenRecord& prev = entry.tokens[index - 1];
+            resumeOffset = prev.offset + prev.length;
+        }
+        return false;
+    }
+
+    auto info = alloc.emplace<Token::Info>();
+    string_view rawText(source + rec.offset, rec.length);
+    info->location = SourceLocation(bufferId, rec.offset);
+    info->setRawText(rawText);
+    info->numFlags.raw = rec.numFlags;
+
+    switch (rec.kind) {
+        case TokenKind::IntegerLiteral:
+            info->setInt(alloc, SVInt(rec.intWidth, rec.payload, rec.intSigned != 0));
+            break;
+        case TokenKind::StringLiteral: {
+            auto length = size_t(rec.payload & UINT32_MAX);
+            char* text = reinterpret_cast<char*>(alloc.allocate(length, 1));
+            memcpy(text, entry.strings + (rec.payload >> 32), length);
+            info->setStringText(alloc, string_view(text, length));
+            break;
+        }
+        default:
+            memcpy(&info->extra, &rec.payload, sizeof(info->extra));
+            break;
+    }
+
+    info->identifierId = entry.identifiers[index];
+
+    if (rec.triviaCount) {
+        auto trivia = reinterpret_cast<Trivia*>(
+            alloc.allocate(sizeof(Trivia) * rec.triviaCount, alignof(Trivia)));
+        for (uint32_t i = 0; i < rec.triviaCount; i++) {
+            const TriviaRecord& t = entry.trivia[rec.firstTrivia + i];
+            string_view text = t.offset == CanonicalText ? getCanonicalText(t.kind)
+                                                         : string_view(source + t.offset, t.length);
+            new (&trivia[i]) Trivia(t.kind, text);
+        }
+        info->setTrivia({ trivia, rec.triviaCount });
+    }
+
+    result = Token(rec.kind, info);
+    return true;
+}
+
+bool TokenCache::record(Recorder& recorder, Token token, KeywordVersion keywordVersion) {
+    auto info = token.getInfo();
+    string_view source = recorder.source;
+    string_view rawText = info->rawText();
+    auto inSource = [&](string_view text) {
+        return text.data() >= source.data() &&
+               text.data() + text.size() <= source.data() + source.size();
+    };
+
+    // Tokens that aren't a plain view of the source text can't be cached; the lexer
+    // doesn't produce any of those for files without errors, but be defensive.
+    size_t rawOffset = size_t(rawText.data() - source.data());
+    if (!inSource(rawText) || info->location.offset() != rawOffset) {
+        discard(recorder);
+        return false;
+    }
+
+    TokenRecord rec{};
+    rec.offset = info->location.offset();
+    rec.length = uint32_t(rawText.size());
+    rec.kind = token.kind;
+    rec.numFlags = info->numFlags.raw;
+    rec.keywordVersion = uint8_t(keywordVersion);
+    rec.identifierStart = NoIdentifier;
+
+    switch (token.kind) {
+        case TokenKind::IntegerLiteral: {
+            // Only values that fit in the record's payload are supported; see the
+            // class documentation.
+            const SVInt value = token.intValue();
+            if (value.hasUnknown() || !value.isSingleWord()) {
+                discard(recorder);
+                return false;
+            }
+            rec.payload = *value.getRawData();
+            rec.intWidth = uint8_t(value.getBitWidth());
+            rec.intSigned = value.isSigned();
+            break;
+        }
+        case TokenKind::StringLiteral: {
+            string_view text = info->stringText();
+            rec.payload = (uint64_t(recorder.strings.size()) << 32) | text.size();
+            recorder.strings.append(text);
+            break;
+        }
+        default:
+            memcpy(&rec.payload, &info->extra, sizeof(info->extra));
+            break;
+    }
+
+    if (info->identifierId != IdentifierId::Invalid) {
+        // The interned name is always a suffix of the raw text (minus the leading
+        // backslash of escaped identifiers, for example).
+        string_view name = IdentifierTable::getText(info->identifierId);
+        if (name.size() > rawText.size() || rawText.size() - name.size() >= NoIdentifier ||
+            rawText.substr(rawText.size() - name.size()) != name) {
+            discard(recorder);
+            return false;
+        }
+        rec.identifierStart = uint8_t(rawText.size() - name.size());
+    }
+    recorder.identifiers.push_back(info->identifierId);
+
+    rec.firstTrivia = uint32_t(recorder.trivia.size());
+    rec.triviaCount = uint32_t(info->trivia().size());
+    for (const Trivia& trivia : info->trivia()) {
+        if (!isTextTrivia(trivia.kind)) {
+            discard(recorder);
+            return false;
+        }
+
+        TriviaRecord t{};
+        t.kind = trivia.kind;
+
+        string_view text = trivia.getRawText();
+        if (inSource(text)) {
+            t.offset = uint32_t(text.data() - source.data());
+            t.length = uint32_t(text.size());
+        }
+        else if ((trivia.kind == TriviaKind::Whitespace || trivia.kind == TriviaKind::EndOfLine) &&
+                 text == getCanonicalText(trivia.kind)) {
+            t.offset = CanonicalText;
+        }
+        else {
+            discard(recorder);
+            return false;
+        }
+        recorder.trivia.push_back(t);
+    }
+
+    recorder.tokens.push_back(rec);
+    if (token.kind != TokenKind::EndOfFile)
+        return true;
+
+    // That's the whole file; serialize it and make it available to other lexers.
+    FileHeader header{};
+    header.magic = FileMagic;
+    header.formatVersion = FormatVersion;
+    header.contentHash = recorder.contentHash;
+    header.contentSize = uint32_t(source.size());
+    header.preserveTrivia = recorder.preserveTrivia;
+    header.keywordVersion = uint8_t(recorder.keywordVersion);
+    header.tokenCount = uint32_t(recorder.tokens.size());
+    header.triviaCount = uint32_t(recorder.trivia.size());
+    header.stringBytes = uint32_t(recorder.strings.size());
+
+    size_t tokenBytes = recorder.tokens.size() * sizeof(TokenRecord);
+    size_t triviaBytes = recorder.trivia.size() * sizeof(TriviaRecord);
+    size_t totalBytes = sizeof(FileHeader) + tokenBytes + triviaBytes + recorder.strings.size();
+
+    auto entry = std::make_unique<Entry>();
+    entry->mem.resize((totalBytes + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+
+    char* data = reinterpret_cast<char*>(entry->mem.data());
+    memcpy(data, &header, sizeof(FileHeader));
+    memcpy(data + sizeof(FileHeader), recorder.tokens.data(), tokenBytes);
+    memcpy(data + sizeof(FileHeader) + tokenBytes, recorder.trivia.data(), triviaBytes);
+    memcpy(data + sizeof(FileHeader) + tokenBytes + triviaBytes, recorder.strings.data(),
+           recorder.strings.size());
+
+    uint64_t key = recorder.key;
+    bool valid = entry->init(data, totalBytes, source, recorder.contentHash,
+                             recorder.preserveTrivia, recorder.keywordVersion);
+    entry->identifiers = std::move(recorder.identifiers);
+    discard(recorder);
+    if (!valid)
+        return false;
+
+    if (!directory.empty())
+        writeEntry(key, data, totalBytes);
+
+    std::unique_lock lock(mut);
+    entries.emplace(key, std::move(entry));
+    return false;
+}
+
+void TokenCache::writeEntry(uint64_t key, const char* data, size_t size) {
+    // Write to a temporary file and then move it into place, so that other processes
+    // sharing the cache never see a partially written entry.
+    fs::path path = getEntryPath(directory, key);
+    fs::path tempPath = path;
+    tempPath += getTempSuffix();
+    bool valid;
+    {
+        std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+        stream.write(data, (std::streamsize)size);
+        valid = bool(stream);
+    }
+
+    std::error_code ec;
+    if (valid)
+        fs::rename(tempPath, path, ec);
+    if (!valid || ec)
+        fs::remove(tempPath, ec);
+}
+
+void TokenCache::discard(Recorder& recorder) {
+    std::unique_lock lock(mut);
+    recorders.erase(&recorder);
+}
+
+std::unique_ptr<TokenCache::Entry> TokenCache::Entry::load(const fs::path& path,
+                                                           string_view source,
+                                                           uint64_t contentHash,
+                                                           bool preserveTrivia,
+                                                           KeywordVersion keywordVersion) {
+    auto entry = std::make_unique<Entry>();
+
+#if HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+
+    auto closeFile = finally([fd] { ::close(fd); });
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+        return nullptr;
+
+    size_t size = (size_t)st.st_size;
+    void* base = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED)
+        return nullptr;
+
+    entry->mapped = base;
+    entry->mappedSize = size;
+    const void* data = base;
+#else
+    std::error_code ec;
+    uintmax_t size = fs::file_size(path, ec);
+    if (ec)
+        return nullptr;
+
+    entry->mem.resize((size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream.read(reinterpret_cast<char*>(entry->mem.data()), (std::streamsize)size))
+        return nullptr;
+    const void* data = entry->mem.data();
+#endif
+
+    if (!entry->init(data, size, source, contentHash, preserveTrivia, keywordVersion))
+        return nullptr;
+
+    entry->internIdentifiers(source);
+    return entry;
+}
+
+} // namespace slang
@@ -37,7 +37,7 @@ DefinitionSymbol::DefinitionSymbol(Compilation& compilation, string_view name, S
                                    DefinitionKind definitionKind, const NetType& defaultNetType) :
     Symbol(SymbolKind::Definition, name, loc),
     Scope(compilation, this), definitionKind(definitionKind), defaultNetType(defaultNetType),
-    portMap(compilation.allocSymbolMap()) {
+    portMap(compilation.allocPortMap()) {
 }
 
 const ModportSymbol* DefinitionSymbol::getModportOrError(string_view modport, const Scope& scope,
@@ -192,7 +192,7 @@ void InstanceSymbol::fromSyntax(Compilation& compilation,
                                 const HierarchyInstantiationSyntax& syntax, LookupLocation location,
                                 const Scope& scope, SmallVector<const Symbol*>& results) {
 
-    auto definition = compilation.getDefinition(syntax.type.valueText(), scope);
+    auto definition = compilation.getDefinition(syntax.type.identifierId(), scope);
     if (!definition) {
         scope.addDiag(DiagCode::UnknownModule, syntax.type.range()) << syntax.type.valueText();
         return;
@@ -340,7 +340,7 @@ void InstanceSymbol::fromSyntax(Compilation& compilation,
 InstanceSymbol::InstanceSymbol(SymbolKind kind, Compilation& compilation, string_view name,
                                SourceLocation loc, const DefinitionSymbol& definition) :
     Symbol(kind, name, loc),
-    Scope(compilation, this), definition(definition), portMap(compilation.allocSymbolMap()) {
+    Scope(compilation, this), definition(definition), portMap(compilation.allocPortMap()) {
 }
 
 void InstanceSymbol::toJson(json& j) const {
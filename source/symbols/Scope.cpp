@@ -297,6 +297,17 @@ void Scope::addMembers(const SyntaxNode& syntax) {
 }
 
 const Symbol* Scope::find(string_view name) const {
+    // Elaborate first so that any members it adds have had their names interned;
+    // after that, a name that was never interned can't be a member.
+    ensureElaborated();
+    IdentifierId id = IdentifierTable::find(name);
+    if (id == IdentifierId::Invalid)
+        return nullptr;
+
+    return find(id);
+}
+
+const Symbol* Scope::find(IdentifierId name) const {
     // Just do a simple lookup and return the result if we have one.
     ensureElaborated();
     auto it = nameMap->find(name);
@@ -361,7 +372,8 @@ void Scope::lookupName(const NameSyntax& syntax, LookupLocation location,
     }
 
     // Perform the lookup.
-    lookupUnqualifiedImpl(name, location, nameToken.range(), flags, result);
+    lookupUnqualifiedImpl(name, nameToken.identifierId(), location, nameToken.range(), flags,
+                          result);
     if (selectors)
         result.selectors.appendRange(*selectors);
 
@@ -376,7 +388,8 @@ const Symbol* Scope::lookupUnqualifiedName(string_view name, LookupLocation loca
         return nullptr;
 
     LookupResult result;
-    lookupUnqualifiedImpl(name, location, sourceRange, flags, result);
+    lookupUnqualifiedImpl(name, IdentifierTable::intern(name), location, sourceRange, flags,
+                          result);
     if (result.hasError())
         getCompilation().addDiagnostics(result.getDiagnostics());
 
@@ -416,7 +429,7 @@ void Scope::insertMember(const Symbol* member, const Symbol* at) const {
     if (!member->name.empty() && member->kind != SymbolKind::Port &&
         member->kind != SymbolKind::Definition && member->kind != SymbolKind::Package) {
 
-        auto pair = nameMap->emplace(member->name, member);
+        auto pair = nameMap->emplace(IdentifierTable::intern(member->name), member);
         if (!pair.second) {
             // TODO: handle special generate block name conflict rules
 
@@ -539,12 +552,12 @@ void Scope::elaborate() const {
                     // Only a few kinds of symbols can have port maps; grab that port map
                     // now so we can add each port to it for future lookup.
                     // The const_cast here is ugly but valid.
-                    SymbolMap* portMap;
+                    PortMap* portMap;
                     const Symbol& sym = asSymbol();
                     if (sym.kind == SymbolKind::Definition)
-                        portMap = const_cast<SymbolMap*>(&sym.as<DefinitionSymbol>().getPortMap());
+                        portMap = const_cast<PortMap*>(&sym.as<DefinitionSymbol>().getPortMap());
                     else
-                        portMap = const_cast<SymbolMap*>(&sym.as<InstanceSymbol>().getPortMap());
+                        portMap = const_cast<PortMap*>(&sym.as<InstanceSymbol>().getPortMap());
 
                     const Symbol* last = symbol;
                     for (auto port : ports) {
@@ -649,7 +662,7 @@ void Scope::elaborate() const {
 
         // Try to do a lookup by name; if the program is well-formed we'll find the
         // corresponding full typedef. If we don't, issue an error.
-        auto it = nameMap->find(symbol->name);
+        auto it = nameMap->find(IdentifierTable::find(symbol->name));
         ASSERT(it != nameMap->end());
 
         if (it->second->kind == SymbolKind::TypeAlias)
@@ -659,14 +672,14 @@ void Scope::elaborate() const {
     }
 }
 
-void Scope::lookupUnqualifiedImpl(string_view name, LookupLocation location,
+void Scope::lookupUnqualifiedImpl(string_view name, IdentifierId nameId, LookupLocation location,
                                   SourceRange sourceRange, bitmask<LookupFlags> flags,
                                   LookupResult& result) const {
     ensureElaborated();
 
     // Try a simple name lookup to see if we find anything.
     const Symbol* symbol = nullptr;
-    if (auto it = nameMap->find(name); it != nameMap->end()) {
+    if (auto it = nameMap->find(nameId); it != nameMap->end()) {
         // If the lookup is for a local name, check that we can access the symbol (it must be
         // declared before use). Callables and block names can be referenced anywhere in the
         // scope, so the location doesn't matter for them.
@@ -739,7 +752,7 @@ void Scope::lookupUnqualifiedImpl(string_view name, LookupLocation location,
         if (!package)
             continue;
 
-        const Symbol* imported = package->find(name);
+        const Symbol* imported = package->find(nameId);
         if (imported)
             imports.emplace(Import{ imported, import });
     }
@@ -774,7 +787,7 @@ void Scope::lookupUnqualifiedImpl(string_view name, LookupLocation location,
         return;
 
     location = LookupLocation::after(asSymbol());
-    return nextScope->lookupUnqualifiedImpl(name, location, sourceRange, flags, result);
+    return nextScope->lookupUnqualifiedImpl(name, nameId, location, sourceRange, flags, result);
 }
 
 namespace {
@@ -941,7 +954,7 @@ bool lookupDownward(span<const NamePlusLoc> nameParts, Token nameToken,
         if (nameToken.valueText().empty())
             return false;
 
-        symbol = current.find(nameToken.valueText());
+        symbol = current.find(nameToken.identifierId());
         if (!symbol) {
             // Give a slightly nicer error if this is the first component in a package lookup.
             DiagCode code = DiagCode::CouldNotResolveHierarchicalPath;
@@ -978,11 +991,12 @@ bool lookupUpward(Compilation& compilation, string_view name, span<const NamePlu
     // Upward lookups can match either a scope name, or a module definition name (on any of the
     // instances). Imports are not considered.
     const Scope* scope = &context.scope;
+    IdentifierId nameId = nameToken.identifierId();
     while (true) {
         const Scope* nextInstance = nullptr;
 
         while (scope) {
-            auto symbol = scope->find(name);
+            auto symbol = scope->find(nameId);
             if (!symbol || symbol->isValue() || symbol->isType() || !symbol->isScope()) {
                 // We didn't find an instance name, so now look at the definition types of each
                 // instance.
@@ -1119,7 +1133,8 @@ void Scope::lookupQualified(const ScopedNameSyntax& syntax, LookupLocation locat
     }
 
     // Start by trying to find the first name segment using normal unqualified lookup
-    lookupUnqualifiedImpl(name, location, nameToken.range(), flags, result);
+    lookupUnqualifiedImpl(name, nameToken.identifierId(), location, nameToken.range(), flags,
+                          result);
     if (result.hasError())
         return;
 
@@ -1129,7 +1144,7 @@ void Scope::lookupQualified(const ScopedNameSyntax& syntax, LookupLocation locat
         // If the prefix name can be resolved normally, we have a class scope, otherwise it's a
         // package lookup.
         if (!result.found) {
-            result.found = compilation.getPackage(name);
+            result.found = compilation.getPackage(nameToken.identifierId());
 
             if (!result.found) {
                 result.addDiag(*this, DiagCode::UnknownClassOrPackage, nameToken.range()) << name;
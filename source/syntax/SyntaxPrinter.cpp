@@ -24,6 +24,11 @@ SyntaxPrinter& SyntaxPrinter::print(Trivia trivia) {
                     print(t);
             }
             break;
+        case TriviaKind::DisabledText:
+            // Text in inactive conditional branches belongs with the directives.
+            if (includeDirectives)
+                append(trivia.getRawText());
+            break;
         case TriviaKind::SkippedSyntax:
             if (includeSkipped)
                 print(*trivia.syntax());
@@ -135,10 +140,8 @@ void SyntaxPrinter::append(string_view text) {
             i++;
         }
 
-        for (; i < text.length(); i++) {
-            if (text[i] == '\r' || text[i] == '\n')
-                i++;
-        }
+        while (i < text.length() && (text[i] == '\r' || text[i] == '\n'))
+            i++;
 
         text = text.substr(i);
     }
@@ -6,6 +6,12 @@
 //------------------------------------------------------------------------------
 #include "slang/syntax/SyntaxTree.h"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <numeric>
+#include <thread>
+
 #include "slang/parsing/Parser.h"
 #include "slang/parsing/Preprocessor.h"
 #include "slang/text/SourceManager.h"
@@ -47,6 +53,60 @@ std::shared_ptr<SyntaxTree> SyntaxTree::fromBuffer(const SourceBuffer& buffer,
     return create(sourceManager, buffer, options, false);
 }
 
+std::vector<std::shared_ptr<SyntaxTree>> SyntaxTree::fromBuffers(span<const SourceBuffer> buffers,
+                                                                 SourceManager& sourceManager,
+                                                                 const Bag& options,
+                                                                 uint32_t threadCount) {
+    size_t count = (size_t)buffers.size();
+    std::vector<std::shared_ptr<SyntaxTree>> results(count);
+    std::vector<std::exception_ptr> errors(count);
+
+    // Hand out the largest buffers first so that one big file picked up at the
+    // very end doesn't leave all of the other threads sitting idle.
+    std::vector<size_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&buffers](size_t a, size_t b) {
+        return buffers[a].data.size() > buffers[b].data.size();
+    });
+
+    // Each buffer is completely independent, so every worker just keeps grabbing the
+    // next unclaimed one until they're all gone. Results are stored by input index
+    // so that the output order doesn't depend on thread scheduling.
+    std::atomic<size_t> next = 0;
+    auto worker = [&] {
+        size_t i;
+        while ((i = next++) < count) {
+            size_t index = order[i];
+            try {
+                results[index] = create(sourceManager, buffers[index], options, false);
+            }
+            catch (...) {
+                errors[index] = std::current_exception();
+            }
+        }
+    };
+
+    if (threadCount == 0)
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    threadCount = (uint32_t)std::min(size_t(threadCount), count);
+
+    // The calling thread does its share of the work too.
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < threadCount; i++)
+        threads.emplace_back(worker);
+
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+
+    for (auto& error : errors) {
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    return results;
+}
+
 SourceManager& SyntaxTree::getDefaultSourceManager() {
     static SourceManager instance;
     return instance;
@@ -54,10 +114,19 @@ SourceManager& SyntaxTree::getDefaultSourceManager() {
 
 SyntaxTree::SyntaxTree(SyntaxNode* root, SourceManager& sourceManager, BumpAllocator&& alloc,
                        Diagnostics&& diagnostics, Parser::MetadataMap&& metadataMap,
-                       Bag options, Token eof) :
+                       Bag options, Token eof, span<const BufferID> sourceBuffers) :
     rootNode(root),
     sourceMan(sourceManager), metadataMap(std::move(metadataMap)), alloc(std::move(alloc)),
-    diagnosticsBuffer(std::move(diagnostics)), options_(std::move(options)), eof(eof) {
+    diagnosticsBuffer(std::move(diagnostics)), options_(std::move(options)), eof(eof),
+    retainedBuffers(sourceBuffers.begin(), sourceBuffers.end()) {
+
+    for (BufferID buffer : retainedBuffers)
+        sourceMan.retainText(buffer);
+}
+
+SyntaxTree::~SyntaxTree() {
+    for (BufferID buffer : retainedBuffers)
+        sourceMan.releaseText(buffer);
 }
 
 std::shared_ptr<SyntaxTree> SyntaxTree::create(SourceManager& sourceManager, SourceBuffer source,
@@ -80,7 +149,8 @@ std::shared_ptr<SyntaxTree> SyntaxTree::create(SourceManager& sourceManager, Sou
 
     return std::shared_ptr<SyntaxTree>(
         new SyntaxTree(root, sourceManager, std::move(alloc), std::move(diagnostics),
-                       parser.getMetadataMap(), options, parser.getEOFToken()));
+                       parser.getMetadataMap(), options, parser.getEOFToken(),
+                       preprocessor.getSourceBuffers()));
 }
 
 } // namespace slang
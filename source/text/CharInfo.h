@@ -6,6 +6,8 @@
 //------------------------------------------------------------------------------
 #pragma once
 
+#include "slang/numeric/SVInt.h"
+
 namespace slang {
 
 /// Returns whether the given character is a valid ASCII character.
@@ -122,20 +124,126 @@ inline logic_t getLogicCharValue(char c) {
     }
 }
 
-/// Returns the number of bytes to skip after reading a UTF-8 character.
-inline int utf8SeqBytes(char c) {
-    unsigned char uc = static_cast<unsigned char>(c);
-    if ((uc & (3 << 6)) == 0)
-        return 0;
-    if ((uc & (1 << 5)) == 0)
+/// Checks the UTF-8 sequence that starts with the given non-ASCII character. Returns the
+/// number of characters in the sequence and sets @a valid to whether they are a well-formed
+/// encoding of a code point; overlong encodings, surrogates, and values past U+10FFFF are
+/// all ill-formed. An ill-formed sequence ends right before the first character that can't
+/// continue it, so that scanning can pick up from there. The text must be null terminated.
+inline int getUTF8SeqLength(const char* ptr, bool& valid) {
+    unsigned char lead = static_cast<unsigned char>(ptr[0]);
+    unsigned char lo = 0x80;
+    unsigned char hi = 0xBF;
+    int count;
+    if (lead >= 0xC2 && lead <= 0xDF)
+        count = 2;
+    else if (lead >= 0xE0 && lead <= 0xEF) {
+        count = 3;
+        if (lead == 0xE0)
+            lo = 0xA0;
+        else if (lead == 0xED)
+            hi = 0x9F;
+    }
+    else if (lead >= 0xF0 && lead <= 0xF4) {
+        count = 4;
+        if (lead == 0xF0)
+            lo = 0x90;
+        else if (lead == 0xF4)
+            hi = 0x8F;
+    }
+    else {
+        valid = false;
         return 1;
-    if ((uc & (1 << 4)) == 0)
-        return 2;
-    if ((uc & (1 << 3)) == 0)
-        return 3;
+    }
 
-    // 5 and 6 byte sequences are disallowed by the UTF-8 spec
-    return 0;
+    // Only the first continuation byte has a restricted range.
+    for (int i = 1; i < count; i++) {
+        unsigned char c = static_cast<unsigned char>(ptr[i]);
+        if (c < lo || c > hi) {
+            valid = false;
+            return i;
+        }
+        lo = 0x80;
+        hi = 0xBF;
+    }
+
+    valid = true;
+    return count;
 }
 
+// The functions below classify and convert runs of digits eight characters at a time,
+// using plain integer arithmetic on a word holding all of them (SWAR). Words are loaded
+// with the first character in the most significant byte, so that digits come out in
+// the same order as they would with a character-by-character loop.
+namespace swar {
+
+constexpr uint64_t Ones = 0x0101010101010101ull;
+constexpr uint64_t HighBits = 0x8080808080808080ull;
+
+/// Loads eight characters, the first of which ends up in the most significant byte.
+/// There must be at least eight readable characters at @a ptr.
+inline uint64_t loadChars(const char* ptr) {
+    uint64_t result = 0;
+    for (int i = 0; i < 8; i++)
+        result = (result << 8) | static_cast<unsigned char>(ptr[i]);
+    return result;
+}
+
+/// Sets the high bit of each byte in the given word that lies strictly between
+/// @a low and @a high; all other bits are clear. Requires @a low < 128 and
+/// @a high <= 128.
+inline uint64_t bytesBetween(uint64_t chars, uint64_t low, uint64_t high) {
+    uint64_t lowBits = chars & (Ones * 127);
+    return (Ones * (127 + high) - lowBits) & ~chars & (lowBits + Ones * (127 - low)) & HighBits;
+}
+
+/// Returns whether all eight characters are decimal digits.
+inline bool allDecimalDigits(uint64_t chars) {
+    return bytesBetween(chars, '0' - 1, '9' + 1) == HighBits;
+}
+
+/// Returns whether all eight characters are binary digits.
+inline bool allBinaryDigits(uint64_t chars) {
+    return (chars & (Ones * 0xFE)) == Ones * '0';
+}
+
+/// Returns whether all eight characters are octal digits.
+inline bool allOctalDigits(uint64_t chars) {
+    return (chars & (Ones * 0xF8)) == Ones * '0';
+}
+
+/// Returns whether all eight characters are hexadecimal digits.
+inline bool allHexDigits(uint64_t chars) {
+    return (bytesBetween(chars, '0' - 1, '9' + 1) | bytesBetween(chars, 'a' - 1, 'f' + 1) |
+            bytesBetween(chars, 'A' - 1, 'F' + 1)) == HighBits;
+}
+
+/// Gets the combined value of eight decimal digits.
+inline uint32_t getDecimalValue(uint64_t chars) {
+    // Combine adjacent lanes, doubling their width each time; no lane can overflow.
+    uint64_t v = chars & (Ones * 0x0F);
+    v = ((v >> 8) & 0x00FF00FF00FF00FFull) * 10 + (v & 0x00FF00FF00FF00FFull);
+    v = ((v >> 16) & 0x0000FFFF0000FFFFull) * 100 + (v & 0x0000FFFF0000FFFFull);
+    return uint32_t((v >> 32) * 10000 + (v & 0xFFFFFFFFull));
+}
+
+/// Packs eight digits of @a bitsPerDigit bits each (1 for binary, 3 for octal, and 4
+/// for hex) into a single value, given a word holding the value of each digit in
+/// the corresponding byte.
+inline uint32_t packDigits(uint64_t digits, uint32_t bitsPerDigit) {
+    uint64_t pairMask = (1ull << (2 * bitsPerDigit)) - 1;
+    uint64_t quadMask = (1ull << (4 * bitsPerDigit)) - 1;
+    digits = (digits | (digits >> (8 - bitsPerDigit))) & (pairMask * 0x0001000100010001ull);
+    digits = (digits | (digits >> (16 - 2 * bitsPerDigit))) & (quadMask * 0x0000000100000001ull);
+    return uint32_t((digits | (digits >> (32 - 4 * bitsPerDigit))) &
+                    ((1ull << (8 * bitsPerDigit)) - 1));
+}
+
+/// Gets the value of each of eight hex digits, one per byte.
+inline uint64_t getHexDigitValues(uint64_t chars) {
+    // Letters have bit 6 set and a low nibble one greater than their offset from 'a'.
+    return (chars & (Ones * 0x0F)) + ((chars >> 6) & Ones) * 9;
+}
+
+} // namespace swar
+
 } // namespace slang
\ No newline at end of file
@@ -0,0 +1,75 @@
+//------------------------------------------------------------------------------
+// SIMD.h
+// Helpers for scanning blocks of characters with vector instructions.
+//
+// File is under the MIT license; see LICENSE for details
+//------------------------------------------------------------------------------
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define SLANG_HAS_SIMD 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    include <emmintrin.h>
+#    define SLANG_HAS_SIMD 1
+#endif
+
+#if defined(SLANG_HAS_SIMD)
+
+namespace slang::simd {
+
+#    if defined(__AVX2__)
+
+/// The number of characters examined by each block operation.
+inline constexpr size_t BlockSize = 32;
+
+/// Returns a mask with bit N set if the character at ptr[N] is equal to any of
+/// the given characters. BlockSize characters are read starting at @a ptr;
+/// there are no alignment requirements.
+template<char... Cs>
+inline uint32_t matchAny(const char* ptr) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+    __m256i result = _mm256_setzero_si256();
+    ((result = _mm256_or_si256(result, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(Cs)))), ...);
+    return (uint32_t)_mm256_movemask_epi8(result);
+}
+
+/// Returns a mask with bit N set if the character at ptr[N] is outside the ASCII range.
+inline uint32_t matchNonASCII(const char* ptr) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+    return (uint32_t)_mm256_movemask_epi8(block);
+}
+
+#    else
+
+/// The number of characters examined by each block operation.
+inline constexpr size_t BlockSize = 16;
+
+/// Returns a mask with bit N set if the character at ptr[N] is equal to any of
+/// the given characters. BlockSize characters are read starting at @a ptr;
+/// there are no alignment requirements.
+template<char... Cs>
+inline uint32_t matchAny(const char* ptr) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+    __m128i result = _mm_setzero_si128();
+    ((result = _mm_or_si128(result, _mm_cmpeq_epi8(block, _mm_set1_epi8(Cs)))), ...);
+    return (uint32_t)_mm_movemask_epi8(result);
+}
+
+/// Returns a mask with bit N set if the character at ptr[N] is outside the ASCII range.
+inline uint32_t matchNonASCII(const char* ptr) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+    return (uint32_t)_mm_movemask_epi8(block);
+}
+
+#    endif
+
+/// A mask with one bit set for every character in a block.
+inline constexpr uint32_t FullMask = uint32_t((uint64_t(1) << BlockSize) - 1);
+
+} // namespace slang::simd
+
+#endif
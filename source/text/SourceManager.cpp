@@ -6,16 +6,41 @@
 //------------------------------------------------------------------------------
 #include "slang/text/SourceManager.h"
 
+#include <cstring>
 #include <fstream>
 
+#if defined(__unix__) || defined(__APPLE__)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#    define HAS_MMAP 1
+#endif
+
+#include "CharInfo.h"
+#include "SIMD.h"
+#include "slang/numeric/MathUtils.h"
+#include "slang/util/Hash.h"
 #include "slang/util/StackContainer.h"
 
 namespace slang {
 
-SourceManager::SourceManager() {
+static std::string getDisplayName(const fs::path& path) {
+    std::error_code ec;
+    fs::path rel = fs::proximate(path, ec);
+    if (ec || rel.empty())
+        return path.filename().string();
+    return rel.string();
+}
+
+SourceManager::SourceManager(SourceManagerOptions options) : options(options) {
     // add a dummy entry to the start of the directory list so that our file IDs line up
-    FileInfo file;
-    bufferEntries.emplace_back(file);
+    entryKinds.emplace_back(EntryKind::File);
+    entryIndices.emplace_back(0u);
+    fileEntries.emplace_back();
+
+    // macro name index zero means no name
+    macroNames.emplace_back();
 }
 
 std::string SourceManager::makeAbsolutePath(string_view path) const {
@@ -24,10 +49,16 @@ std::string SourceManager::makeAbsolutePath(string_view path) const {
 
 void SourceManager::addSystemDirectory(string_view path) {
     systemDirectories.push_back(fs::canonical(path));
+
+    std::unique_lock lock(mut);
+    includeCache.clear();
 }
 
 void SourceManager::addUserDirectory(string_view path) {
     userDirectories.push_back(fs::canonical(path));
+
+    std::unique_lock lock(mut);
+    includeCache.clear();
 }
 
 uint32_t SourceManager::getLineNumber(SourceLocation location) const {
@@ -37,6 +68,7 @@ uint32_t SourceManager::getLineNumber(SourceLocation location) const {
         return 0;
 
     FileData* fd = getFileData(fileLocation.buffer());
+    std::shared_lock lock(lineDirectiveMut);
     auto lineDirective = fd->getPreviousLineDirective(rawLineNumber);
 
     if (!lineDirective)
@@ -50,13 +82,24 @@ uint32_t SourceManager::getColumnNumber(SourceLocation location) const {
     if (!fd)
         return 0;
 
-    // walk backward to find start of line
-    uint32_t lineStart = location.offset();
-    ASSERT(lineStart < fd->mem.size());
-    while (lineStart > 0 && fd->mem[lineStart - 1] != '\n' && fd->mem[lineStart - 1] != '\r')
-        lineStart--;
+    // Find the start of the line using the same table we use for line numbers,
+    // which avoids rescanning long lines on every call. The first entry is always
+    // zero, so there's guaranteed to be an entry before the upper bound.
+    uint32_t offset = location.offset();
+    auto& lineOffsets = getLineOffsets(*fd);
+    auto it = std::upper_bound(lineOffsets.begin(), lineOffsets.end(), offset);
+    uint32_t lineStart = *(it - 1);
+
+    // The table treats \r\n and \n\r as a single line break; a location pointing
+    // at the second char of such a pair starts a new column count.
+    if (offset > lineStart) {
+        string_view text = getText(*fd);
+        ASSERT(offset < text.size());
+        if (text[offset - 1] == '\n' || text[offset - 1] == '\r')
+            lineStart = offset;
+    }
 
-    return location.offset() - lineStart + 1;
+    return offset - lineStart + 1;
 }
 
 string_view SourceManager::getFileName(SourceLocation location) const {
@@ -66,14 +109,20 @@ string_view SourceManager::getFileName(SourceLocation location) const {
     FileData* fd = getFileData(fileLocation.buffer());
     if (!fd)
         return "";
-    else if (fd->lineDirectives.empty())
+
+    std::shared_lock lock(lineDirectiveMut);
+    if (fd->lineDirectives.empty())
         return string_view(fd->name);
 
-    auto lineDirective = fd->getPreviousLineDirective(getRawLineNumber(fileLocation));
+    lock.unlock();
+    uint32_t rawLineNumber = getRawLineNumber(fileLocation);
+
+    lock.lock();
+    auto lineDirective = fd->getPreviousLineDirective(rawLineNumber);
     if (!lineDirective)
         return string_view(fd->name);
     else
-        return string_view(lineDirective->name);
+        return lineDirective->name;
 }
 
 string_view SourceManager::getRawFileName(BufferID buffer) const {
@@ -85,28 +134,20 @@ string_view SourceManager::getRawFileName(BufferID buffer) const {
 }
 
 SourceLocation SourceManager::getIncludedFrom(BufferID buffer) const {
-    if (!buffer)
+    if (!buffer || !isFileLoc(SourceLocation(buffer, 0)))
         return SourceLocation();
 
-    ASSERT(buffer.id < bufferEntries.size());
-    const FileInfo* info = std::get_if<FileInfo>(&bufferEntries[buffer.id]);
-    return info ? info->includedFrom : SourceLocation();
+    return getFileInfo(buffer).includedFrom;
 }
 
 string_view SourceManager::getMacroName(SourceLocation location) const {
     while (isMacroArgLoc(location))
         location = getExpansionLoc(location);
 
-    auto buffer = location.buffer();
-    if (!buffer)
-        return {};
-
-    ASSERT(buffer.id < bufferEntries.size());
-    auto info = std::get_if<ExpansionInfo>(&bufferEntries[buffer.id]);
-    if (!info)
+    if (!isMacroLoc(location))
         return {};
 
-    return info->macroName;
+    return macroNames[getExpansionInfo(location.buffer()).macroNameIndex];
 }
 
 bool SourceManager::isFileLoc(SourceLocation location) const {
@@ -114,8 +155,8 @@ bool SourceManager::isFileLoc(SourceLocation location) const {
     if (!buffer)
         return false;
 
-    ASSERT(buffer.id < bufferEntries.size());
-    return std::get_if<FileInfo>(&bufferEntries[buffer.id]) != nullptr;
+    ASSERT(buffer.id < entryKinds.size());
+    return entryKinds[buffer.id] == EntryKind::File;
 }
 
 bool SourceManager::isMacroLoc(SourceLocation location) const {
@@ -123,8 +164,8 @@ bool SourceManager::isMacroLoc(SourceLocation location) const {
     if (!buffer)
         return false;
 
-    ASSERT(buffer.id < bufferEntries.size());
-    return std::get_if<ExpansionInfo>(&bufferEntries[buffer.id]) != nullptr;
+    ASSERT(buffer.id < entryKinds.size());
+    return entryKinds[buffer.id] != EntryKind::File;
 }
 
 bool SourceManager::isMacroArgLoc(SourceLocation location) const {
@@ -132,9 +173,8 @@ bool SourceManager::isMacroArgLoc(SourceLocation location) const {
     if (!buffer)
         return false;
 
-    ASSERT(buffer.id < bufferEntries.size());
-    auto info = std::get_if<ExpansionInfo>(&bufferEntries[buffer.id]);
-    return info && info->isMacroArg;
+    ASSERT(buffer.id < entryKinds.size());
+    return entryKinds[buffer.id] == EntryKind::MacroArgExpansion;
 }
 
 bool SourceManager::isIncludedFileLoc(SourceLocation location) const {
@@ -190,8 +230,7 @@ SourceLocation SourceManager::getExpansionLoc(SourceLocation location) const {
     if (!buffer)
         return SourceLocation();
 
-    ASSERT(buffer.id < bufferEntries.size());
-    return std::get<ExpansionInfo>(bufferEntries[buffer.id]).expansionStart;
+    return getExpansionInfo(buffer).expansionStart;
 }
 
 SourceRange SourceManager::getExpansionRange(SourceLocation location) const {
@@ -199,8 +238,7 @@ SourceRange SourceManager::getExpansionRange(SourceLocation location) const {
     if (!buffer)
         return SourceRange();
 
-    ASSERT(buffer.id < bufferEntries.size());
-    const ExpansionInfo& info = std::get<ExpansionInfo>(bufferEntries[buffer.id]);
+    auto& info = getExpansionInfo(buffer);
     return SourceRange(info.expansionStart, info.expansionEnd);
 }
 
@@ -209,9 +247,7 @@ SourceLocation SourceManager::getOriginalLoc(SourceLocation location) const {
     if (!buffer)
         return SourceLocation();
 
-    ASSERT(buffer.id < bufferEntries.size());
-    return std::get<ExpansionInfo>(bufferEntries[buffer.id]).originalLoc +
-           (size_t)location.offset();
+    return getExpansionInfo(buffer).originalLoc + (size_t)location.offset();
 }
 
 SourceLocation SourceManager::getFullyOriginalLoc(SourceLocation location) const {
@@ -235,24 +271,42 @@ string_view SourceManager::getSourceText(BufferID buffer) const {
     if (!fd)
         return "";
 
-    return string_view(fd->mem.data(), fd->mem.size());
+    return getText(*fd);
 }
 
 SourceLocation SourceManager::createExpansionLoc(SourceLocation originalLoc,
                                                  SourceLocation expansionStart,
                                                  SourceLocation expansionEnd, bool isMacroArg) {
-    bufferEntries.emplace_back(
-        ExpansionInfo(originalLoc, expansionStart, expansionEnd, isMacroArg));
-    return SourceLocation(BufferID::get((uint32_t)(bufferEntries.size() - 1)), 0);
+    std::unique_lock lock(mut);
+    return createExpansionEntry(isMacroArg ? EntryKind::MacroArgExpansion : EntryKind::Expansion,
+                                ExpansionInfo(originalLoc, expansionStart, expansionEnd, 0));
 }
 
 SourceLocation SourceManager::createExpansionLoc(SourceLocation originalLoc,
                                                  SourceLocation expansionStart,
                                                  SourceLocation expansionEnd,
                                                  string_view macroName) {
+    std::unique_lock lock(mut);
+
+    uint32_t nameIndex = 0;
+    if (!macroName.empty()) {
+        auto it = macroNameIndices.find(macroName);
+        if (it != macroNameIndices.end()) {
+            nameIndex = it->second;
+        }
+        else {
+            byte* mem = nameAlloc.allocate(macroName.size(), 1);
+            memcpy(mem, macroName.data(), macroName.size());
 
-    bufferEntries.emplace_back(ExpansionInfo(originalLoc, expansionStart, expansionEnd, macroName));
-    return SourceLocation(BufferID::get((uint32_t)(bufferEntries.size() - 1)), 0);
+            string_view name(reinterpret_cast<const char*>(mem), macroName.size());
+            nameIndex = (uint32_t)macroNames.size();
+            macroNames.emplace_back(name);
+            macroNameIndices.emplace(name, nameIndex);
+        }
+    }
+
+    return createExpansionEntry(EntryKind::Expansion,
+                                ExpansionInfo(originalLoc, expansionStart, expansionEnd, nameIndex));
 }
 
 SourceBuffer SourceManager::assignText(string_view text, SourceLocation includedFrom) {
@@ -278,8 +332,58 @@ SourceBuffer SourceManager::assignText(string_view path, string_view text,
 
 SourceBuffer SourceManager::assignBuffer(string_view path, std::vector<char>&& buffer,
                                          SourceLocation includedFrom) {
-    userFileBuffers.emplace_back(FileData(nullptr, std::string(path), std::move(buffer)));
-    return createBufferEntry(&userFileBuffers.back(), includedFrom);
+    std::unique_lock lock(mut);
+    auto& fd = userFileBuffers.emplace_back(nullptr, std::string(path), std::move(buffer));
+    return createBufferEntry(&fd, includedFrom);
+}
+
+uint32_t SourceManager::setOverlay(string_view path, string_view text) {
+    std::error_code ec;
+    fs::path absPath = fs::weakly_canonical(fs::path(path), ec);
+    if (ec)
+        absPath = fs::absolute(fs::path(path));
+
+    std::vector<char> buffer;
+    buffer.reserve(text.size() + 1);
+    buffer.insert(buffer.end(), text.begin(), text.end());
+    buffer.push_back('\0');
+
+    std::unique_lock lock(mut);
+    auto& fd = overlayBuffers.emplace_back(&*directories.insert(absPath.parent_path()).first,
+                                           getDisplayName(absPath), std::move(buffer));
+
+    // Each edit gets a new FileData so that buffers handed out for previous
+    // versions (and the syntax trees built from them) remain valid.
+    auto& entry = overlays[absPath.string()];
+    fd.version = entry ? entry->version + 1 : 1;
+
+    // Any cached include resolution could be affected, including ones that found
+    // a different file with the same name further down the search path.
+    includeCache.clear();
+
+    entry = &fd;
+    hasOverlays = true;
+    return fd.version;
+}
+
+void SourceManager::removeOverlay(string_view path) {
+    std::error_code ec;
+    fs::path absPath = fs::weakly_canonical(fs::path(path), ec);
+    if (ec)
+        absPath = fs::absolute(fs::path(path));
+
+    std::unique_lock lock(mut);
+    auto it = overlays.find(absPath.string());
+    if (it == overlays.end())
+        return;
+
+    includeCache.clear();
+    overlays.erase(it);
+}
+
+uint32_t SourceManager::getVersion(BufferID buffer) const {
+    FileData* fd = getFileData(buffer);
+    return fd ? fd->version : 0;
 }
 
 SourceBuffer SourceManager::readSource(string_view path) {
@@ -289,16 +393,49 @@ SourceBuffer SourceManager::readSource(string_view path) {
 
 SourceBuffer SourceManager::readHeader(string_view path, SourceLocation includedFrom,
                                        bool isSystemPath) {
-    // if the header is specified as an absolute path, just do a straight lookup
     ASSERT(!path.empty());
     fs::path p = path;
-    if (p.is_absolute())
-        return openCached(p, includedFrom);
+
+    // Relative user includes are first searched for next to the including file,
+    // so the result depends on which directory that is.
+    const fs::path* directory = nullptr;
+    if (!isSystemPath && !p.is_absolute()) {
+        FileData* fd = getFileData(includedFrom.buffer());
+        if (fd)
+            directory = fd->directory;
+    }
+
+    // See if we've already resolved this include. This is the common case for
+    // large designs, and it lets us skip hitting the file system for every
+    // candidate include directory.
+    IncludeKey key{ directory, std::string(path), isSystemPath };
+    {
+        std::unique_lock lock(mut);
+        auto it = includeCache.find(key);
+        if (it != includeCache.end()) {
+            if (!it->second)
+                return SourceBuffer();
+            return createBufferEntry(it->second, includedFrom);
+        }
+    }
+
+    SourceBuffer result = resolveHeader(p, directory, includedFrom, isSystemPath);
+
+    std::unique_lock lock(mut);
+    includeCache.emplace(std::move(key), result ? getFileData(result.id) : nullptr);
+    return result;
+}
+
+SourceBuffer SourceManager::resolveHeader(const fs::path& path, const fs::path* directory,
+                                          SourceLocation includedFrom, bool isSystemPath) {
+    // if the header is specified as an absolute path, just do a straight lookup
+    if (path.is_absolute())
+        return openCached(path, includedFrom);
 
     // system path lookups only look in system directories
     if (isSystemPath) {
         for (auto& d : systemDirectories) {
-            SourceBuffer result = openCached(d / p, includedFrom);
+            SourceBuffer result = openCached(d / path, includedFrom);
             if (result.id)
                 return result;
         }
@@ -306,16 +443,15 @@ SourceBuffer SourceManager::readHeader(string_view path, SourceLocation included
     }
 
     // search relative to the current file
-    FileData* fd = getFileData(includedFrom.buffer());
-    if (fd && fd->directory) {
-        SourceBuffer result = openCached((*fd->directory) / p, includedFrom);
+    if (directory) {
+        SourceBuffer result = openCached(*directory / path, includedFrom);
         if (result.id)
             return result;
     }
 
     // search additional include directories
     for (auto& d : userDirectories) {
-        SourceBuffer result = openCached(d / p, includedFrom);
+        SourceBuffer result = openCached(d / path, includedFrom);
         if (result.id)
             return result;
     }
@@ -338,42 +474,101 @@ void SourceManager::addLineDirective(SourceLocation location, uint32_t lineNum,
         full = fs::path(fd->name).replace_filename(linePath);
 
     uint32_t sourceLineNum = getRawLineNumber(fileLocation);
-    fd->lineDirectives.emplace_back(full.string(), sourceLineNum, lineNum, level);
+    std::unique_lock lock(lineDirectiveMut);
+
+    // Keep directives sorted by line so that lookups can binary search them. The same
+    // file can be preprocessed more than once, so ignore directives we've already seen.
+    auto& directives = fd->lineDirectives;
+    auto it = std::lower_bound(
+        directives.begin(), directives.end(), sourceLineNum,
+        [](const LineDirectiveInfo& info, uint32_t line) { return info.lineInFile < line; });
+    if (it != directives.end() && it->lineInFile == sourceLineNum)
+        return;
+
+    string_view fileName = *lineDirectiveNames.insert(full.string()).first;
+    directives.emplace(it, fileName, sourceLineNum, lineNum, level);
 }
 
 SourceManager::FileData* SourceManager::getFileData(BufferID buffer) const {
-    if (!buffer)
+    if (!buffer || !isFileLoc(SourceLocation(buffer, 0)))
         return nullptr;
 
-    ASSERT(buffer.id < bufferEntries.size());
-    return std::get<FileInfo>(bufferEntries[buffer.id]).data;
+    return getFileInfo(buffer).data;
+}
+
+const SourceManager::FileInfo& SourceManager::getFileInfo(BufferID buffer) const {
+    ASSERT(buffer.id < entryKinds.size());
+    ASSERT(entryKinds[buffer.id] == EntryKind::File);
+    return fileEntries[entryIndices[buffer.id]];
+}
+
+const SourceManager::ExpansionInfo& SourceManager::getExpansionInfo(BufferID buffer) const {
+    ASSERT(buffer.id < entryKinds.size());
+    ASSERT(entryKinds[buffer.id] != EntryKind::File);
+    return expansionEntries[entryIndices[buffer.id]];
 }
 
 SourceBuffer SourceManager::createBufferEntry(FileData* fd, SourceLocation includedFrom) {
     ASSERT(fd);
-    bufferEntries.emplace_back(FileInfo(fd, includedFrom));
-    return SourceBuffer{ string_view(fd->mem.data(), fd->mem.size()),
-                         BufferID::get((uint32_t)(bufferEntries.size() - 1)) };
+    uint32_t id = (uint32_t)entryKinds.size();
+    entryIndices.emplace_back((uint32_t)fileEntries.size());
+    fileEntries.emplace_back(fd, includedFrom);
+    entryKinds.emplace_back(EntryKind::File);
+    return SourceBuffer{ getTextLocked(*fd), BufferID::get(id) };
+}
+
+SourceLocation SourceManager::createExpansionEntry(EntryKind kind, const ExpansionInfo& info) {
+    uint32_t id = (uint32_t)entryKinds.size();
+    entryIndices.emplace_back((uint32_t)expansionEntries.size());
+    expansionEntries.emplace_back(info);
+    entryKinds.emplace_back(kind);
+    return SourceLocation(BufferID::get(id), 0);
 }
 
 SourceBuffer SourceManager::openCached(const fs::path& fullPath, SourceLocation includedFrom) {
     std::error_code ec;
+
+    // in-memory overlays take precedence over whatever is on disk
+    if (hasOverlays.load(std::memory_order_relaxed)) {
+        fs::path overlayPath = fs::weakly_canonical(fullPath, ec);
+        if (!ec) {
+            std::unique_lock lock(mut);
+            auto it = overlays.find(overlayPath.string());
+            if (it != overlays.end())
+                return createBufferEntry(it->second, includedFrom);
+        }
+    }
+
     fs::path absPath = fs::canonical(fullPath, ec);
     if (ec)
         return SourceBuffer();
 
     // first see if we have this file cached
-    auto it = lookupCache.find(absPath.string());
-    if (it != lookupCache.end()) {
-        FileData* fd = it->second.get();
-        if (!fd)
-            return SourceBuffer();
-        return createBufferEntry(fd, includedFrom);
+    {
+        std::unique_lock lock(mut);
+        auto it = lookupCache.find(absPath.string());
+        if (it != lookupCache.end()) {
+            FileData* fd = it->second.get();
+            if (!fd)
+                return SourceBuffer();
+            return createBufferEntry(fd, includedFrom);
+        }
     }
 
-    // do the read
+    // If we get here we need to do the load. This happens without holding the lock
+    // so that other threads can make progress while we wait on the file system.
+    // If requested, try to map the file directly into memory.
+    if (options.memoryMapFiles) {
+        size_t size;
+        auto mapping = mapFile(absPath, size);
+        if (mapping)
+            return cacheBuffer(absPath, includedFrom, std::move(mapping), size);
+    }
+
+    // otherwise do a normal read
     std::vector<char> buffer;
     if (!readFile(absPath, buffer)) {
+        std::unique_lock lock(mut);
         lookupCache.emplace(absPath.string(), nullptr);
         return SourceBuffer();
     }
@@ -381,41 +576,267 @@ SourceBuffer SourceManager::openCached(const fs::path& fullPath, SourceLocation
     return cacheBuffer(absPath, includedFrom, std::move(buffer));
 }
 
+template<typename... Args>
 SourceBuffer SourceManager::cacheBuffer(const fs::path& path, SourceLocation includedFrom,
-                                        std::vector<char>&& buffer) {
-    std::string name;
-    std::error_code ec;
-    fs::path rel = fs::proximate(path, ec);
-    if (ec || rel.empty())
-        name = path.filename().string();
-    else
-        name = rel.string();
+                                        Args&&... fileContents) {
+    auto fd = std::make_unique<FileData>(nullptr, getDisplayName(path),
+                                         std::forward<Args>(fileContents)...);
+
+    size_t hash = 0;
+    if (options.deduplicateContents)
+        hash = xxhash(fd->text.data(), fd->text.size(), 0);
+
+    std::unique_lock lock(mut);
+
+    // Another thread may have loaded the same file while we were busy reading it;
+    // if so, just use that copy and discard ours.
+    auto& entry = lookupCache[path.string()];
+    if (entry)
+        return createBufferEntry(entry.get(), includedFrom);
+
+    fd->directory = &*directories.insert(path.parent_path()).first;
+
+    // If some other file has the exact same contents, share them instead
+    // of keeping a second copy around.
+    if (options.deduplicateContents) {
+        auto [begin, end] = contentCache.equal_range(hash);
+        for (auto it = begin; it != end; ++it) {
+            if (getTextLocked(*it->second) == fd->text) {
+                fd = std::make_unique<FileData>(fd->directory, std::move(fd->name), *it->second);
+                break;
+            }
+        }
 
-    auto fd = std::make_unique<FileData>(&*directories.insert(path.parent_path()).first,
-                                         std::move(name), std::move(buffer));
+        if (!fd->contentSource)
+            contentCache.emplace(hash, fd.get());
+    }
 
-    FileData* fdPtr = lookupCache.emplace(path.string(), std::move(fd)).first->second.get();
-    return createBufferEntry(fdPtr, includedFrom);
+    entry = std::move(fd);
+    entry->diskPath = &lookupCache.find(path.string())->first;
+    return createBufferEntry(entry.get(), includedFrom);
 }
 
-void SourceManager::computeLineOffsets(const std::vector<char>& buffer,
-                                       std::vector<uint32_t>& offsets) {
-    // first line always starts at offset 0
-    offsets.push_back(0);
+string_view SourceManager::getText(FileData& fd) const {
+    FileData& owner = fd.contentSource ? *fd.contentSource : fd;
+    if (owner.textResident.load(std::memory_order_acquire))
+        return owner.text;
 
-    const char* ptr = buffer.data();
-    const char* end = buffer.data() + buffer.size();
+    std::unique_lock lock(mut);
+    return getTextLocked(owner);
+}
+
+string_view SourceManager::getTextLocked(FileData& fd) const {
+    FileData& owner = fd.contentSource ? *fd.contentSource : fd;
+    if (owner.textResident.load(std::memory_order_relaxed))
+        return owner.text;
+
+    // Superseded overlay versions have nowhere to be reloaded from.
+    string_view text;
+    if (owner.diskPath) {
+        fs::path path = *owner.diskPath;
+
+        size_t size;
+        std::unique_ptr<MappedFile> mapping;
+        if (options.memoryMapFiles)
+            mapping = mapFile(path, size);
+
+        if (mapping && size + 1 == owner.textSize) {
+            owner.mapping = std::move(mapping);
+            text = string_view(owner.mapping->data(), owner.textSize);
+        }
+        else if (readFile(path, owner.mem) && owner.mem.size() == owner.textSize) {
+            text = string_view(owner.mem.data(), owner.mem.size());
+        }
+    }
+
+    // If the file has changed since we first loaded it, all of the locations we've
+    // handed out would be wrong, so fill it with blank space instead.
+    if (text.empty() || xxhash(text.data(), text.size(), 0) != owner.textHash) {
+        owner.mapping.reset();
+        owner.mem.assign(owner.textSize, ' ');
+        owner.mem.back() = '\0';
+        text = string_view(owner.mem.data(), owner.mem.size());
+    }
+
+    owner.text = text;
+    owner.textResident.store(true, std::memory_order_release);
+    return text;
+}
+
+optional<uint32_t> SourceManager::getInvalidEncodingOffset(BufferID buffer) const {
+    FileData* fd = getFileData(buffer);
+    if (!fd)
+        return std::nullopt;
+
+    // Zero means the file hasn't been checked yet, one means it's valid, and anything
+    // else is two more than the offset of the first ill-formed sequence. Two threads
+    // might both end up doing the check, but they'll always agree on the result.
+    FileData& owner = fd->contentSource ? *fd->contentSource : *fd;
+    uint32_t state = owner.encodingCheck.load(std::memory_order_relaxed);
+    if (!state) {
+        auto offset = findInvalidEncoding(getText(owner));
+        state = offset ? *offset + 2 : 1;
+        owner.encodingCheck.store(state, std::memory_order_relaxed);
+    }
+
+    if (state == 1)
+        return std::nullopt;
+    return state - 2;
+}
+
+optional<uint32_t> SourceManager::findInvalidEncoding(string_view text) {
+    // Nearly all source text is plain ASCII, so look for anything else a whole
+    // block at a time and only decode the sequences that turn up.
+    const char* start = text.data();
+    const char* end = start + text.size();
+    const char* ptr = start;
     while (ptr != end) {
-        if (ptr[0] == '\n' || ptr[0] == '\r') {
-            // if we see \r\n or \n\r skip both chars
-            if ((ptr[1] == '\n' || ptr[1] == '\r') && ptr[0] != ptr[1])
-                ptr++;
-            ptr++;
-            offsets.push_back((uint32_t)(ptr - buffer.data()));
+#if defined(SLANG_HAS_SIMD)
+        if (end - ptr >= (ptrdiff_t)simd::BlockSize) {
+            uint32_t mask = simd::matchNonASCII(ptr);
+            if (!mask) {
+                ptr += simd::BlockSize;
+                continue;
+            }
+            ptr += countTrailingZeros32(mask);
         }
-        else {
+#endif
+
+        if (isASCII(*ptr)) {
             ptr++;
+            continue;
         }
+
+        bool valid;
+        int length = getUTF8SeqLength(ptr, valid);
+        if (!valid)
+            return uint32_t(ptr - start);
+        ptr += length;
+    }
+    return std::nullopt;
+}
+
+void SourceManager::retainText(BufferID buffer) {
+    FileData* fd = getFileData(buffer);
+    if (fd)
+        (fd->contentSource ? fd->contentSource : fd)->textRefs++;
+}
+
+void SourceManager::releaseText(BufferID buffer) {
+    FileData* fd = getFileData(buffer);
+    if (fd) {
+        auto& refs = (fd->contentSource ? fd->contentSource : fd)->textRefs;
+        ASSERT(refs > 0);
+        refs--;
+    }
+}
+
+size_t SourceManager::releaseUnusedText(size_t budget) {
+    std::unique_lock lock(mut);
+
+    // Overlay versions that have been replaced or removed can't be loaded
+    // anymore, so only existing buffers need their text. Those go first.
+    std::unordered_set<const FileData*> currentOverlays;
+    for (auto& [path, fd] : overlays)
+        currentOverlays.insert(fd);
+
+    size_t resident = 0;
+    std::vector<FileData*> candidates;
+    for (auto& fd : overlayBuffers) {
+        if (!fd.textResident.load(std::memory_order_relaxed))
+            continue;
+
+        resident += fd.text.size();
+        if (fd.textRefs == 0 && currentOverlays.count(&fd) == 0)
+            candidates.push_back(&fd);
+    }
+
+    // Otherwise only files that were loaded from disk (and that own their
+    // text) can be released, since they're the only ones we can reload.
+    for (auto& [path, fd] : lookupCache) {
+        if (!fd || fd->contentSource || !fd->textResident.load(std::memory_order_relaxed))
+            continue;
+
+        resident += fd->text.size();
+        if (fd->textRefs == 0)
+            candidates.push_back(fd.get());
+    }
+
+    size_t released = 0;
+    for (FileData* fd : candidates) {
+        if (resident <= budget)
+            break;
+
+        // Line numbers are still needed without the text, so
+        // make sure they've been computed before we drop it.
+        getLineOffsets(*fd);
+
+        fd->textHash = xxhash(fd->text.data(), fd->text.size(), 0);
+        fd->textSize = fd->text.size();
+        fd->textResident.store(false, std::memory_order_relaxed);
+        fd->text = {};
+        fd->mem = std::vector<char>();
+        fd->mapping.reset();
+
+        resident -= fd->textSize;
+        released += fd->textSize;
+    }
+
+    return released;
+}
+
+const std::vector<uint32_t>& SourceManager::getLineOffsets(FileData& fd) {
+    // files with shared contents also share line offsets
+    if (fd.contentSource)
+        return getLineOffsets(*fd.contentSource);
+
+    // compute line offsets if we haven't already
+    std::call_once(fd.lineOffsetsComputed, [&fd] { computeLineOffsets(fd.text, fd.lineOffsets); });
+    return fd.lineOffsets;
+}
+
+void SourceManager::computeLineOffsets(string_view buffer, std::vector<uint32_t>& offsets) {
+    // first line always starts at offset 0
+    offsets.push_back(0);
+
+    const char* start = buffer.data();
+    const char* ptr = start;
+    const char* end = start + buffer.size();
+
+    // Records the line break at p and returns a pointer just past it.
+    auto skipLineBreak = [&](const char* p) {
+        // if we see \r\n or \n\r skip both chars
+        if (p + 1 != end && (p[1] == '\n' || p[1] == '\r') && p[0] != p[1])
+            p++;
+        p++;
+        offsets.push_back((uint32_t)(p - start));
+        return p;
+    };
+
+#if defined(SLANG_HAS_SIMD)
+    // The vast majority of characters aren't line breaks, so check a whole block
+    // at a time and then only look at the positions that matched.
+    while (end - ptr >= (ptrdiff_t)simd::BlockSize) {
+        const char* block = ptr;
+        const char* next = block;
+        uint32_t mask = simd::matchAny<'\n', '\r'>(block);
+        while (mask) {
+            const char* p = block + countTrailingZeros32(mask);
+            mask &= mask - 1;
+
+            // skip the second half of a two char line break we already handled
+            if (p >= next)
+                next = skipLineBreak(p);
+        }
+        ptr = std::max(block + simd::BlockSize, next);
+    }
+#endif
+
+    while (ptr != end) {
+        if (ptr[0] == '\n' || ptr[0] == '\r')
+            ptr = skipLineBreak(ptr);
+        else
+            ptr++;
     }
 }
 
@@ -439,6 +860,53 @@ bool SourceManager::readFile(const fs::path& path, std::vector<char>& buffer) {
     return true;
 }
 
+std::unique_ptr<SourceManager::MappedFile> SourceManager::mapFile(const fs::path& path,
+                                                                  size_t& size) {
+#if HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+
+    auto closeFile = finally([fd] { ::close(fd); });
+
+    // Empty files and things like pipes or devices can't be usefully mapped;
+    // let the caller fall back to reading them normally.
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+        return nullptr;
+
+    // Reserve room for the file plus at least one extra byte, rounded up to a whole
+    // page, using an anonymous (and therefore zero filled) mapping. The file itself
+    // is then mapped over the front of that region, which guarantees that there is a
+    // readable null terminator right after the end of the file's contents even when
+    // the file size is an exact multiple of the page size.
+    size = (size_t)st.st_size;
+    size_t pageSize = (size_t)::sysconf(_SC_PAGESIZE);
+    size_t mappedSize = (size + pageSize) & ~(pageSize - 1);
+
+    void* base = ::mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        return nullptr;
+
+    if (::mmap(base, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        ::munmap(base, mappedSize);
+        return nullptr;
+    }
+
+    return std::make_unique<MappedFile>(base, mappedSize);
+#else
+    (void)path;
+    (void)size;
+    return nullptr;
+#endif
+}
+
+SourceManager::MappedFile::~MappedFile() {
+#if HAS_MMAP
+    ::munmap(base, mappedSize);
+#endif
+}
+
 const SourceManager::LineDirectiveInfo* SourceManager::FileData::getPreviousLineDirective(
     uint32_t rawLineNumber) const {
     auto it = std::lower_bound(
@@ -465,18 +933,15 @@ uint32_t SourceManager::getRawLineNumber(SourceLocation location) const {
     if (!fd)
         return 0;
 
-    // compute line offsets if we haven't already
-    if (fd->lineOffsets.empty())
-        computeLineOffsets(fd->mem, fd->lineOffsets);
-
     // Find the first line offset that is greater than the given location offset. That iterator
     // then tells us how many lines away from the beginning we are.
-    auto it = std::lower_bound(fd->lineOffsets.begin(), fd->lineOffsets.end(), location.offset());
+    auto& lineOffsets = getLineOffsets(*fd);
+    auto it = std::lower_bound(lineOffsets.begin(), lineOffsets.end(), location.offset());
 
     // We want to ensure the line we return is strictly greater than the given location offset.
     // So if it is equal, add one to the lower bound we got.
-    uint32_t line = uint32_t(it - fd->lineOffsets.begin());
-    if (it != fd->lineOffsets.end() && *it == location.offset())
+    uint32_t line = uint32_t(it - lineOffsets.begin());
+    if (it != lineOffsets.end() && *it == location.offset())
         line++;
     return line;
 }
@@ -0,0 +1,308 @@
+//------------------------------------------------------------------------------
+// CommandLine.cpp
+// Command file expansion and file name globbing for tool command lines.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#include "slang/util/CommandLine.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <fmt/format.h>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace slang {
+
+static void expandArgs(span<const std::string> input, const fs::path* baseDir,
+                       std::vector<std::string>& results, std::vector<std::string>& warnings,
+                       int depth);
+
+/// Reads the arguments contained in a command file (-f or -F) and expands them into
+/// @a results. For -F files, relative paths in the file are relative to the directory
+/// containing the command file instead of the current directory.
+static void expandCommandFile(const std::string& fileName, bool relativePaths,
+                              std::vector<std::string>& results,
+                              std::vector<std::string>& warnings, int depth) {
+    if (depth > 32)
+        throw std::runtime_error(fmt::format("command files nested too deeply: '{}'", fileName));
+
+    std::ifstream stream(fileName);
+    if (!stream)
+        throw std::runtime_error(fmt::format("unable to open command file '{}'", fileName));
+
+    std::vector<std::string> args;
+    std::string line;
+    while (std::getline(stream, line)) {
+        size_t i = 0;
+        while (i < line.size()) {
+            char c = line[i];
+            if (isspace((unsigned char)c)) {
+                i++;
+                continue;
+            }
+
+            if (c == '#' || (c == '/' && i + 1 < line.size() && line[i + 1] == '/'))
+                break;
+
+            std::string arg;
+            if (c == '"' || c == '\'') {
+                size_t end = line.find(c, i + 1);
+                if (end == std::string::npos)
+                    end = line.size();
+                arg = line.substr(i + 1, end - i - 1);
+                i = end + 1;
+            }
+            else {
+                while (i < line.size() && !isspace((unsigned char)line[i]))
+                    arg += line[i++];
+            }
+            args.emplace_back(std::move(arg));
+        }
+    }
+
+    fs::path dir = fs::absolute(fileName).parent_path();
+    expandArgs(args, relativePaths ? &dir : nullptr, results, warnings, depth);
+}
+
+static void expandArgs(span<const std::string> input, const fs::path* baseDir,
+                       std::vector<std::string>& results, std::vector<std::string>& warnings,
+                       int depth) {
+    auto makePath = [baseDir](const std::string& path) {
+        if (!baseDir || path.empty() || fs::path(path).is_absolute())
+            return path;
+        return (*baseDir / path).string();
+    };
+
+    auto getValue = [&](ptrdiff_t& i) -> const std::string& {
+        if (++i == input.size())
+            throw std::runtime_error(fmt::format("missing value for '{}'", input[i - 1]));
+        return input[i];
+    };
+
+    for (ptrdiff_t i = 0; i < input.size(); i++) {
+        const std::string& arg = input[i];
+        if (arg == "-f" || arg == "-F") {
+            const std::string& file = getValue(i);
+            expandCommandFile(makePath(file), arg == "-F", results, warnings, depth + 1);
+        }
+        else if (arg == "-I" || arg == "--include-directory" ||
+                 arg == "--include-system-directory" || arg == "-y" || arg == "--libdir") {
+            results.push_back(arg);
+            results.push_back(makePath(getValue(i)));
+        }
+        else if (arg == "-D" || arg == "--define-macro" || arg == "-U" ||
+                 arg == "--undefine-macro" || arg == "--libext" || arg == "-j" ||
+                 arg == "--threads" || arg == "--ast-json") {
+            results.push_back(arg);
+            results.push_back(getValue(i));
+        }
+        else if (arg.size() > 1 && arg[0] == '+') {
+            // +name+value1+value2...
+            size_t nameEnd = arg.find('+', 1);
+            std::string name = arg.substr(1, nameEnd == std::string::npos ? nameEnd : nameEnd - 1);
+
+            std::vector<std::string> values;
+            while (nameEnd != std::string::npos && nameEnd + 1 < arg.size()) {
+                size_t next = arg.find('+', nameEnd + 1);
+                values.push_back(arg.substr(nameEnd + 1, next == std::string::npos
+                                                             ? next
+                                                             : next - nameEnd - 1));
+                nameEnd = next;
+            }
+
+            const char* option;
+            if (name == "incdir")
+                option = "-I";
+            else if (name == "define")
+                option = "-D";
+            else if (name == "libext")
+                option = "--libext";
+            else {
+                warnings.push_back(fmt::format("ignoring unknown option '{}'", arg));
+                continue;
+            }
+
+            for (auto& value : values) {
+                results.push_back(option);
+                results.push_back(name == "incdir" ? makePath(value) : value);
+            }
+        }
+        else if (!arg.empty() && arg[0] == '-') {
+            results.push_back(arg);
+        }
+        else {
+            results.push_back(makePath(arg));
+        }
+    }
+}
+
+std::vector<std::string> expandCommandLine(span<const std::string> args,
+                                           std::vector<std::string>& warnings) {
+    std::vector<std::string> results;
+    expandArgs(args, nullptr, results, warnings, 0);
+    return results;
+}
+
+bool isGlobPattern(string_view path) {
+    return path.find_first_of("*?") != string_view::npos;
+}
+
+namespace {
+
+/// Matches a single path component against a pattern, where * matches any
+/// sequence of characters and ? matches any single character.
+bool matchComponent(string_view pattern, string_view name) {
+    size_t p = 0, n = 0;
+    size_t starP = string_view::npos, starN = 0;
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            p++;
+            n++;
+        }
+        else if (p < pattern.size() && pattern[p] == '*') {
+            starP = p++;
+            starN = n;
+        }
+        else if (starP != string_view::npos) {
+            p = starP + 1;
+            n = ++starN;
+        }
+        else {
+            return false;
+        }
+    }
+
+    while (p < pattern.size() && pattern[p] == '*')
+        p++;
+    return p == pattern.size();
+}
+
+/// Walks the directories named by a set of glob patterns with a pool of threads,
+/// each of which picks up the next directory to look at from a shared queue.
+class GlobExpander {
+public:
+    explicit GlobExpander(uint32_t numThreads) : numThreads(std::max(numThreads, 1u)) {}
+
+    std::vector<std::vector<fs::path>> expand(span<const std::string> patterns) {
+        results.resize(patterns.size());
+        for (ptrdiff_t i = 0; i < patterns.size(); i++) {
+            // Split off the leading part of the path that doesn't have any wildcards.
+            fs::path base;
+            std::vector<std::string> parts;
+            for (auto& part : fs::path(patterns[i])) {
+                std::string str = part.string();
+                if (parts.empty() && !isGlobPattern(str))
+                    base /= part;
+                else
+                    parts.push_back(str);
+            }
+
+            ASSERT(!parts.empty());
+            if (parts.back() == "**")
+                parts.push_back("*");
+
+            segments.push_back(std::move(parts));
+            tasks.push_back({ base.empty() ? fs::path(".") : base, (size_t)i, 0 });
+        }
+
+        std::vector<std::thread> threads;
+        for (uint32_t i = 1; i < numThreads; i++)
+            threads.emplace_back([this] { worker(); });
+
+        worker();
+        for (auto& thread : threads)
+            thread.join();
+
+        for (auto& files : results) {
+            std::sort(files.begin(), files.end());
+            files.erase(std::unique(files.begin(), files.end()), files.end());
+        }
+        return std::move(results);
+    }
+
+private:
+    struct Task {
+        fs::path dir;
+        size_t pattern;
+        size_t segment;
+    };
+
+    void worker() {
+        std::unique_lock lock(mutex);
+        while (true) {
+            cv.wait(lock, [this] { return !tasks.empty() || active == 0; });
+            if (tasks.empty())
+                return;
+
+            Task task = std::move(tasks.back());
+            tasks.pop_back();
+            active++;
+
+            lock.unlock();
+            process(task);
+            lock.lock();
+
+            active--;
+            cv.notify_all();
+        }
+    }
+
+    void process(const Task& task) {
+        auto& parts = segments[task.pattern];
+        const std::string& segment = parts[task.segment];
+        bool isLast = task.segment + 1 == parts.size();
+
+        std::vector<Task> newTasks;
+        std::vector<fs::path> files;
+        if (segment == "**")
+            newTasks.push_back({ task.dir, task.pattern, task.segment + 1 });
+
+        std::error_code ec;
+        for (auto it = fs::directory_iterator(task.dir, ec); !ec && it != fs::directory_iterator();
+             it.increment(ec)) {
+            auto& entry = *it;
+            if (segment == "**") {
+                // Don't follow symlinks here; a link back up the tree would otherwise
+                // have us recursing forever.
+                if (entry.is_directory(ec) && !entry.is_symlink(ec))
+                    newTasks.push_back({ entry.path(), task.pattern, task.segment });
+            }
+            else if (matchComponent(segment, entry.path().filename().string())) {
+                if (isLast) {
+                    if (entry.is_regular_file(ec))
+                        files.push_back(entry.path());
+                }
+                else if (entry.is_directory(ec)) {
+                    newTasks.push_back({ entry.path(), task.pattern, task.segment + 1 });
+                }
+            }
+        }
+
+        std::unique_lock lock(mutex);
+        auto& resultList = results[task.pattern];
+        resultList.insert(resultList.end(), files.begin(), files.end());
+        for (auto& newTask : newTasks)
+            tasks.push_back(std::move(newTask));
+    }
+
+    uint32_t numThreads;
+    std::vector<std::vector<std::string>> segments;
+    std::vector<std::vector<fs::path>> results;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<Task> tasks;
+    size_t active = 0;
+};
+
+} // namespace
+
+std::vector<std::vector<fs::path>> expandGlobs(span<const std::string> patterns,
+                                               uint32_t numThreads) {
+    return GlobExpander(numThreads).expand(patterns);
+}
+
+} // namespace slang
@@ -0,0 +1,111 @@
+//------------------------------------------------------------------------------
+// IdentifierTable.cpp
+// Global interning table for identifier names.
+//
+// File is under the MIT license; see LICENSE for details.
+//------------------------------------------------------------------------------
+#include "slang/util/IdentifierTable.h"
+
+#include <cstring>
+#include <flat_hash_map.hpp>
+#include <mutex>
+#include <shared_mutex>
+
+#include "slang/util/AppendOnlyVector.h"
+#include "slang/util/BumpAllocator.h"
+
+namespace slang {
+
+namespace {
+
+struct TableState {
+    // Protects the ID map and the text allocator. The text list is append-only
+    // and can be read without holding the lock.
+    std::shared_mutex mut;
+    flat_hash_map<string_view, IdentifierId> ids;
+    AppendOnlyVector<string_view, 1024> texts;
+    BumpAllocator alloc;
+
+    TableState() {
+        // Index zero is reserved for IdentifierId::Invalid.
+        texts.emplace_back();
+    }
+};
+
+TableState& getState() {
+    static TableState state;
+    return state;
+}
+
+// Each thread remembers the names it has already looked up, keyed on the table's own
+// copy of the text. Most identifiers in a design are repeated many times, so once a
+// thread has warmed up it rarely needs to touch the shared lock at all, which keeps
+// threads that are lexing in parallel from contending with each other.
+flat_hash_map<string_view, IdentifierId>& getLocalCache() {
+    thread_local flat_hash_map<string_view, IdentifierId> cache;
+    return cache;
+}
+
+} // namespace
+
+IdentifierId IdentifierTable::intern(string_view name) {
+    if (name.empty())
+        return IdentifierId::Invalid;
+
+    auto& cache = getLocalCache();
+    if (auto it = cache.find(name); it != cache.end())
+        return it->second;
+
+    auto& state = getState();
+    auto remember = [&](IdentifierId id) {
+        cache.emplace(state.texts[uint32_t(id)], id);
+        return id;
+    };
+
+    {
+        std::shared_lock lock(state.mut);
+        if (auto it = state.ids.find(name); it != state.ids.end())
+            return remember(it->second);
+    }
+
+    std::unique_lock lock(state.mut);
+    if (auto it = state.ids.find(name); it != state.ids.end())
+        return remember(it->second);
+
+    byte* mem = state.alloc.allocate(name.size(), 1);
+    memcpy(mem, name.data(), name.size());
+
+    string_view text(reinterpret_cast<const char*>(mem), name.size());
+    auto id = IdentifierId(state.texts.size());
+    state.texts.emplace_back(text);
+    state.ids.emplace(text, id);
+    return remember(id);
+}
+
+IdentifierId IdentifierTable::find(string_view name) {
+    if (name.empty())
+        return IdentifierId::Invalid;
+
+    auto& cache = getLocalCache();
+    if (auto it = cache.find(name); it != cache.end())
+        return it->second;
+
+    auto& state = getState();
+    std::shared_lock lock(state.mut);
+    if (auto it = state.ids.find(name); it != state.ids.end())
+        return it->second;
+    return IdentifierId::Invalid;
+}
+
+string_view IdentifierTable::getText(IdentifierId id) {
+    auto& state = getState();
+    ASSERT(uint32_t(id) < state.texts.size());
+    return state.texts[uint32_t(id)];
+}
+
+size_t IdentifierTable::size() {
+    // Don't count the reserved invalid entry.
+    return getState().texts.size() - 1;
+}
+
+} // namespace slang
@@ -0,0 +1,158 @@
+#include "Test.h"
+
+#include <fstream>
+
+#include "slang/util/CommandLine.h"
+
+static void writeFile(const fs::path& path, const std::string& contents) {
+    fs::create_directories(path.parent_path());
+    std::ofstream stream(path, std::ios::binary);
+    stream.write(contents.data(), (std::streamsize)contents.size());
+}
+
+static std::vector<std::string> expand(std::vector<std::string> args,
+                                       std::vector<std::string>& warnings) {
+    return expandCommandLine(args, warnings);
+}
+
+TEST_CASE("Command files with quoting and comments") {
+    auto dir = getTempPath("cmdfile_quoting");
+    writeFile(dir / "args.f", "# leading comment\n"
+                              "\"file with spaces.sv\" 'single quoted.sv' // trailing comment\n"
+                              "  -D FOO=1   plain.sv\n"
+                              "\t-I\tinc\n"
+                              "'unterminated quote.sv\n");
+
+    std::vector<std::string> warnings;
+    auto args = expand({ "first.sv", "-f", (dir / "args.f").string(), "last.sv" }, warnings);
+
+    std::vector<std::string> expected = { "first.sv",
+                                          "file with spaces.sv",
+                                          "single quoted.sv",
+                                          "-D",
+                                          "FOO=1",
+                                          "plain.sv",
+                                          "-I",
+                                          "inc",
+                                          "unterminated quote.sv",
+                                          "last.sv" };
+    CHECK(args == expected);
+    CHECK(warnings.empty());
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("Nested command files") {
+    auto dir = getTempPath("cmdfile_nested");
+    auto sub = dir / "sub";
+
+    // -F makes paths relative to the command file, including the paths of nested
+    // command files; -f leaves them relative to the current directory.
+    writeFile(dir / "outer.f", "-F sub/inner.f\n"
+                               "-f " + (sub / "plain.f").string() + "\n"
+                               "outer.sv\n");
+    writeFile(sub / "inner.f", "inner.sv -I inc -y lib -D X=y/z " +
+                                   (dir / "abs.sv").string() + "\n");
+    writeFile(sub / "plain.f", "plain.sv -I inc\n");
+
+    std::vector<std::string> warnings;
+    auto args = expand({ "-F", (dir / "outer.f").string() }, warnings);
+
+    std::vector<std::string> expected = { (sub / "inner.sv").string(),
+                                          "-I",
+                                          (sub / "inc").string(),
+                                          "-y",
+                                          (sub / "lib").string(),
+                                          "-D",
+                                          "X=y/z",
+                                          (dir / "abs.sv").string(),
+                                          "plain.sv",
+                                          "-I",
+                                          "inc",
+                                          (dir / "outer.sv").string() };
+    CHECK(args == expected);
+    CHECK(warnings.empty());
+
+    // A command file that includes itself runs into the nesting limit.
+    writeFile(dir / "self.f", "-F self.f\n");
+    CHECK_THROWS_AS(expand({ "-F", (dir / "self.f").string() }, warnings), std::runtime_error);
+
+    CHECK_THROWS_AS(expand({ "-f", (dir / "missing.f").string() }, warnings),
+                    std::runtime_error);
+    CHECK_THROWS_AS(expand({ "a.sv", "-f" }, warnings), std::runtime_error);
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("Command line plusargs") {
+    auto dir = getTempPath("cmdfile_plusargs");
+    writeFile(dir / "args.f", "+incdir+inc1+inc2 +define+A=1+B +libext+.v+.sv\n"
+                              "+incdir+ +notreal+foo +define\n");
+
+    std::vector<std::string> warnings;
+    auto args = expand({ "+incdir+top", "-F", (dir / "args.f").string() }, warnings);
+
+    std::vector<std::string> expected = { "-I",
+                                          "top",
+                                          "-I",
+                                          (dir / "inc1").string(),
+                                          "-I",
+                                          (dir / "inc2").string(),
+                                          "-D",
+                                          "A=1",
+                                          "-D",
+                                          "B",
+                                          "--libext",
+                                          ".v",
+                                          "--libext",
+                                          ".sv" };
+    CHECK(args == expected);
+
+    REQUIRE(warnings.size() == 1);
+    CHECK(warnings[0] == "ignoring unknown option '+notreal+foo'");
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("Glob patterns") {
+    CHECK(isGlobPattern("*.sv"));
+    CHECK(isGlobPattern("a/b?.sv"));
+    CHECK(!isGlobPattern("a/b.sv"));
+
+    auto dir = getTempPath("globs");
+    writeFile(dir / "a.sv", "");
+    writeFile(dir / "b.v", "");
+    writeFile(dir / "sub" / "c.sv", "");
+    writeFile(dir / "sub" / "deep" / "d.sv", "");
+    writeFile(dir / "other" / "e.sv", "");
+
+    // A link back up the tree must not send ** around in circles.
+    std::error_code ec;
+    fs::create_directory_symlink(dir, dir / "sub" / "loop", ec);
+
+    std::string base = dir.string();
+    std::vector<std::string> patterns = { base + "/*.sv",  base + "/**/*.sv",
+                                          base + "/s?b/*", base + "/*/*.sv",
+                                          base + "/**",    base + "/nothing/**/*.sv" };
+
+    auto results = expandGlobs(patterns, 4);
+    REQUIRE(results.size() == patterns.size());
+
+    auto names = [&](const std::vector<fs::path>& paths) {
+        std::vector<std::string> result;
+        for (auto& path : paths)
+            result.push_back(path.lexically_relative(dir).generic_string());
+        return result;
+    };
+
+    using Names = std::vector<std::string>;
+    CHECK(names(results[0]) == Names{ "a.sv" });
+    CHECK(names(results[1]) == Names{ "a.sv", "other/e.sv", "sub/c.sv", "sub/deep/d.sv" });
+    CHECK(names(results[2]) == Names{ "sub/c.sv" });
+    CHECK(names(results[3]) == Names{ "other/e.sv", "sub/c.sv" });
+    CHECK(names(results[4]) ==
+          Names{ "a.sv", "b.v", "other/e.sv", "sub/c.sv", "sub/deep/d.sv" });
+    CHECK(results[5].empty());
+
+    fs::remove_all(dir);
+}
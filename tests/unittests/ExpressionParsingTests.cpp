@@ -56,6 +56,48 @@ TEST_CASE("Integer literal expression") {
     CHECK_DIAGNOSTICS_EMPTY;
 }
 
+SVInt parseVectorLiteral(const std::string& text) {
+    auto& expr = parseExpression(text);
+    REQUIRE(expr.kind == SyntaxKind::IntegerVectorExpression);
+    return expr.as<IntegerVectorExpressionSyntax>().value.intValue();
+}
+
+TEST_CASE("Vector literal values") {
+    // Known digits take a fast path that packs them a word at a time; compare
+    // against SVInt's own digit-by-digit conversion.
+    auto check = [](const std::string& text) {
+        INFO(text);
+        CHECK(exactlyEqual(parseVectorLiteral(text), SVInt::fromString(text)));
+        CHECK_DIAGNOSTICS_EMPTY;
+    };
+
+    check("128'hDEAD_BEEF_0123_4567_89ab_cdef_FFFF_0000");
+    check("72'h0000_0000_0012_3456_789A_BCDE_F0");
+    check("100'b" + std::string(50, '1') + "_" + std::string(49, '0') + "1");
+    check("99'o" + std::string(33, '7'));
+    check("67'sh4_0123_4567_89ab_cdef");
+    check("64'h0123_4567_89ab_cdxf");
+    check("96'b1010_1010_1010_1010_1010_1010_1010_1010_zzzz_0101_0101_0101");
+    check("84'hx_0000_0000_ffff_ffff_0000");
+    check("40'h0000_0000_0000_0000_0");
+    check("8'o0");
+
+    // Unsized literals grow to fit their digits.
+    SVInt value = parseVectorLiteral("'h1_0000_0000_0000_0000_0000");
+    CHECK(value.getBitWidth() == 81);
+    CHECK(exactlyEqual(value, SVInt::fromString("81'h1_0000_0000_0000_0000_0000")));
+
+    value = parseVectorLiteral("'b0000_0000_0000_0001");
+    CHECK(value.getBitWidth() == 32);
+    CHECK(exactlyEqual(value, SVInt::fromString("32'b1")));
+
+    // Literals too wide for their size are truncated from the left.
+    value = parseVectorLiteral("12'h0123_4567_89ab_cdef_0123");
+    CHECK(exactlyEqual(value, SVInt::fromString("12'h123")));
+    REQUIRE(diagnostics.size() == 1);
+    CHECK(diagnostics[0].code == DiagCode::VectorLiteralOverflow);
+}
+
 TEST_CASE("Integer with question") {
     auto& text = "4'b?10?";
     auto& expr = parseExpression(text);
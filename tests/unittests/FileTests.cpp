@@ -1,5 +1,8 @@
 #include "Test.h"
 
+#include <fstream>
+#include <thread>
+
 std::string getTestInclude() {
     return findTestDir() + "/include.svh";
 }
@@ -68,3 +71,413 @@ TEST_CASE("Read header (include dirs)") {
     buffer = manager.readHeader("../infinite_chain.svh", SourceLocation(buffer.id, 0), false);
     CHECK(buffer);
 }
+
+TEST_CASE("Read header (cached resolution)") {
+    SourceManager manager;
+    manager.addUserDirectory(string_view(manager.makeAbsolutePath(string_view(findTestDir()))));
+
+    // a miss should stay a miss until the set of include directories changes
+    CHECK(!manager.readHeader("file.svh", SourceLocation(), false));
+    CHECK(!manager.readHeader("file.svh", SourceLocation(), false));
+
+    // hits should share the same underlying data but get distinct buffers
+    SourceBuffer buffer1 = manager.readHeader("local.svh", SourceLocation(), false);
+    SourceBuffer buffer2 = manager.readHeader("local.svh", SourceLocation(), false);
+    REQUIRE(buffer1);
+    REQUIRE(buffer2);
+    CHECK(buffer1.id != buffer2.id);
+    CHECK(buffer1.data.data() == buffer2.data.data());
+
+    // the same name is looked up separately for system includes
+    CHECK(!manager.readHeader("local.svh", SourceLocation(), true));
+
+    manager.addUserDirectory(
+        string_view(manager.makeAbsolutePath(string_view(findTestDir() + "/nested"))));
+    CHECK(manager.readHeader("file.svh", SourceLocation(), false));
+}
+
+TEST_CASE("Line and column numbers") {
+    // Mix line ending styles and line lengths so that line breaks (and two char
+    // line break pairs) land at various positions relative to block boundaries.
+    std::string text;
+    const char* breaks[] = { "\n", "\r\n", "\n\r", "\r", "\n\n" };
+    for (int i = 0; i < 200; i++) {
+        text.append(size_t(i * 7 % 67), 'a' + char(i % 26));
+        text.append(breaks[i % 5]);
+    }
+
+    SourceManager manager;
+    SourceBuffer buffer = manager.assignText(string_view(text));
+
+    uint32_t line = 1;
+    uint32_t col = 1;
+    for (uint32_t i = 0; i < text.size(); i++) {
+        SourceLocation loc(buffer.id, i);
+        CHECK(manager.getLineNumber(loc) == line);
+        CHECK(manager.getColumnNumber(loc) == col);
+
+        char c = text[i];
+        if (c == '\n' || c == '\r') {
+            col = 1;
+            char n = i + 1 < text.size() ? text[i + 1] : '\0';
+            if ((n == '\n' || n == '\r') && n != c) {
+                // second char of a two char line break
+                i++;
+                CHECK(manager.getColumnNumber(SourceLocation(buffer.id, i)) == 1);
+            }
+            line++;
+        }
+        else {
+            col++;
+        }
+    }
+}
+
+TEST_CASE("Macro expansion entries") {
+    SourceManager manager;
+    SourceBuffer file = manager.assignText("`FOO(a) `BAR");
+    SourceLocation fileLoc(file.id, 0);
+
+    std::string name = "FOO";
+    SourceLocation foo = manager.createExpansionLoc(fileLoc + 20, fileLoc, fileLoc + 7, name);
+    SourceLocation arg = manager.createExpansionLoc(fileLoc + 5, foo + 2, foo + 3, true);
+    SourceLocation bar = manager.createExpansionLoc(fileLoc + 30, fileLoc + 8, fileLoc + 12,
+                                                    string_view(name).substr(0, 3));
+    SourceLocation unnamed = manager.createExpansionLoc(fileLoc, fileLoc, fileLoc, false);
+
+    CHECK(manager.isFileLoc(fileLoc));
+    CHECK(!manager.isMacroLoc(fileLoc));
+    CHECK(manager.isMacroLoc(foo));
+    CHECK(!manager.isMacroArgLoc(foo));
+    CHECK(manager.isMacroArgLoc(arg));
+    CHECK(!manager.isFileLoc(arg));
+
+    CHECK(manager.getMacroName(foo) == "FOO");
+    CHECK(manager.getMacroName(arg) == "FOO");
+    CHECK(manager.getMacroName(bar) == "FOO");
+    CHECK(manager.getMacroName(unnamed).empty());
+
+    CHECK(manager.getExpansionLoc(foo) == fileLoc);
+    CHECK(manager.getExpansionRange(foo).end() == fileLoc + 7);
+    CHECK(manager.getOriginalLoc(arg + 1) == fileLoc + 6);
+    CHECK(manager.getFullyExpandedLoc(arg) == fileLoc + 5);
+    CHECK(manager.getFullyOriginalLoc(foo + 3) == fileLoc + 23);
+    CHECK(manager.getIncludedFrom(foo.buffer()) == SourceLocation());
+}
+
+TEST_CASE("Read source (memory mapped)") {
+    SourceManagerOptions options;
+    options.memoryMapFiles = true;
+
+    SourceManager manager(options);
+    std::string testPath = manager.makeAbsolutePath(string_view(getTestInclude()));
+
+    CHECK(!manager.readSource("X:\\nonsense.txt"));
+
+    auto file = manager.readSource(string_view(testPath));
+    REQUIRE(file);
+    REQUIRE(file.data.length() > 1);
+    CHECK(file.data.back() == '\0');
+
+    // contents should match a normal read of the same file
+    SourceManager other;
+    auto expected = other.readSource(string_view(testPath));
+    REQUIRE(expected);
+    CHECK(file.data == expected.data);
+
+    // include lookups should work the same as well
+    auto nested = manager.readHeader("nested/file.svh", SourceLocation(file.id, 0), false);
+    REQUIRE(nested);
+    CHECK(nested.data.back() == '\0');
+    CHECK(manager.getLineNumber(SourceLocation(nested.id, 0)) == 1);
+}
+
+TEST_CASE("Read source (memory mapped, page sized)") {
+    // A file whose size is an exact multiple of the page size still needs
+    // a null terminator right after its contents.
+    auto path = getTempPath("mmap_test.sv");
+    std::string text(4096, ' ');
+    text.replace(0, 9, "module m;");
+    text.replace(text.size() - 10, 10, "endmodule\n");
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream.write(text.data(), (std::streamsize)text.size());
+    }
+
+    SourceManagerOptions options;
+    options.memoryMapFiles = true;
+
+    SourceManager manager(options);
+    auto file = manager.readSource(path.string());
+    REQUIRE(file);
+    CHECK(file.data.length() == text.size() + 1);
+    CHECK(file.data.substr(0, text.size()) == text);
+    CHECK(file.data.back() == '\0');
+
+    fs::remove(path);
+}
+
+TEST_CASE("Read source (deduplicated contents)") {
+    auto dir = getTempPath("dedup_test");
+    fs::create_directories(dir / "a");
+    fs::create_directories(dir / "b");
+
+    auto writeFile = [](const fs::path& path, const std::string& text) {
+        std::ofstream stream(path, std::ios::binary);
+        stream.write(text.data(), (std::streamsize)text.size());
+    };
+
+    writeFile(dir / "a/pkg.sv", "package p;\n  int i;\nendpackage\n");
+    writeFile(dir / "b/pkg.sv", "package p;\n  int i;\nendpackage\n");
+    writeFile(dir / "b/other.sv", "package q;\n  int i;\nendpackage\n");
+
+    SourceManagerOptions options;
+    options.deduplicateContents = true;
+
+    SourceManager manager(options);
+    auto file1 = manager.readSource((dir / "a/pkg.sv").string());
+    auto file2 = manager.readSource((dir / "b/pkg.sv").string());
+    auto file3 = manager.readSource((dir / "b/other.sv").string());
+    REQUIRE(file1);
+    REQUIRE(file2);
+    REQUIRE(file3);
+
+    CHECK(file1.data.data() == file2.data.data());
+    CHECK(file1.data.data() != file3.data.data());
+
+    // names and line info are still tracked per file
+    SourceLocation loc(file2.id, 15);
+    CHECK(manager.getLineNumber(loc) == 2);
+    CHECK(manager.getColumnNumber(loc) == 5);
+    CHECK(manager.getRawFileName(file1.id) != manager.getRawFileName(file2.id));
+
+    // without the option each file gets its own copy
+    SourceManager other;
+    CHECK(other.readSource((dir / "a/pkg.sv").string()).data.data() !=
+          other.readSource((dir / "b/pkg.sv").string()).data.data());
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("In-memory overlays") {
+    SourceManager manager;
+    manager.addUserDirectory(string_view(manager.makeAbsolutePath(string_view(findTestDir()))));
+
+    // prime the include cache with both a miss and a hit
+    CHECK(!manager.readHeader("unsaved.svh", SourceLocation(), false));
+    SourceBuffer local = manager.readHeader("local.svh", SourceLocation(), false);
+    REQUIRE(local);
+    CHECK(manager.getVersion(local.id) == 0);
+
+    // overlays work for files that don't exist on disk
+    std::string unsavedPath = findTestDir() + "unsaved.svh";
+    CHECK(manager.setOverlay(unsavedPath, "`define UNSAVED 1\n") == 1);
+    SourceBuffer unsaved = manager.readHeader("unsaved.svh", SourceLocation(), false);
+    REQUIRE(unsaved);
+    CHECK(unsaved.data == string_view("`define UNSAVED 1\n\0", 19));
+    CHECK(manager.getVersion(unsaved.id) == 1);
+
+    // and shadow files that do
+    std::string localPath = findTestDir() + "local.svh";
+    CHECK(manager.setOverlay(localPath, "// edited\n") == 1);
+    SourceBuffer edited = manager.readHeader("local.svh", SourceLocation(), false);
+    REQUIRE(edited);
+    CHECK(edited.data.substr(0, 10) == "// edited\n");
+    CHECK(manager.readSource(localPath).data.data() == edited.data.data());
+
+    // further edits bump the version; old buffers stay valid
+    CHECK(manager.setOverlay(localPath, "// edited\n// again\n") == 2);
+    SourceBuffer edited2 = manager.readHeader("local.svh", SourceLocation(), false);
+    REQUIRE(edited2);
+    CHECK(manager.getVersion(edited2.id) == 2);
+    CHECK(manager.getLineNumber(SourceLocation(edited2.id, 12)) == 2);
+    CHECK(manager.getVersion(edited.id) == 1);
+    CHECK(edited.data.substr(0, 10) == "// edited\n");
+    CHECK(manager.getLineNumber(SourceLocation(edited.id, 9)) == 1);
+
+    // removing overlays goes back to the disk contents
+    manager.removeOverlay(localPath);
+    manager.removeOverlay(unsavedPath);
+    CHECK(manager.readHeader("local.svh", SourceLocation(), false).data == local.data);
+    CHECK(!manager.readHeader("unsaved.svh", SourceLocation(), false));
+
+    // versions that have been replaced or removed can have their text dropped,
+    // after which it reads back as blank
+    CHECK(manager.releaseUnusedText() >= edited.data.size() + edited2.data.size());
+    CHECK(manager.getSourceText(edited.id) == string_view("          \0", 11));
+    CHECK(manager.getLineNumber(SourceLocation(edited2.id, 12)) == 2);
+    CHECK(manager.getSourceText(unsaved.id).size() == unsaved.data.size());
+}
+
+TEST_CASE("Overlays in higher priority include directories") {
+    SourceManager manager;
+    std::string systemDir = findTestDir() + "system";
+    manager.addUserDirectory(string_view(manager.makeAbsolutePath(string_view(systemDir))));
+    manager.addUserDirectory(string_view(manager.makeAbsolutePath(string_view(findTestDir()))));
+
+    SourceBuffer local = manager.readHeader("local.svh", SourceLocation(), false);
+    REQUIRE(local);
+    CHECK(manager.getVersion(local.id) == 0);
+
+    // an overlay that shadows the cached result from a later directory takes its place
+    std::string overlayPath = systemDir + "/local.svh";
+    manager.setOverlay(overlayPath, "// shadowed\n");
+    SourceBuffer shadowed = manager.readHeader("local.svh", SourceLocation(), false);
+    REQUIRE(shadowed);
+    CHECK(manager.getVersion(shadowed.id) == 1);
+
+    manager.removeOverlay(overlayPath);
+    CHECK(manager.readHeader("local.svh", SourceLocation(), false).data == local.data);
+}
+
+TEST_CASE("Releasing unused source text") {
+    auto path = getTempPath("release_test.sv");
+    std::string text = "module m;\n  wire w;\nendmodule\n";
+    auto writeFile = [&](const std::string& contents) {
+        std::ofstream stream(path, std::ios::binary);
+        stream.write(contents.data(), (std::streamsize)contents.size());
+    };
+    writeFile(text);
+
+    SourceManager manager;
+    SourceBuffer buffer = manager.readSource(path.string());
+    REQUIRE(buffer);
+
+    // text referenced by a live syntax tree is never released
+    auto tree = SyntaxTree::fromBuffer(buffer, manager);
+    CHECK(manager.releaseUnusedText() == 0);
+    CHECK(manager.getSourceText(buffer.id).data() == buffer.data.data());
+
+    // nor is anything while we're under budget
+    tree.reset();
+    CHECK(manager.releaseUnusedText(1 << 20) == 0);
+    CHECK(manager.releaseUnusedText() == text.size() + 1);
+    CHECK(manager.releaseUnusedText() == 0);
+
+    // released text gets reloaded on demand
+    SourceLocation loc(buffer.id, 14);
+    CHECK(manager.getLineNumber(loc) == 2);
+    CHECK(manager.getColumnNumber(loc) == 5);
+    CHECK(manager.getSourceText(buffer.id).substr(0, text.size()) == text);
+
+    // as well as when the file is loaded again
+    CHECK(manager.releaseUnusedText() == text.size() + 1);
+    SourceBuffer buffer2 = manager.readSource(path.string());
+    REQUIRE(buffer2);
+    CHECK(buffer2.data.substr(0, text.size()) == text);
+
+    // if the file changed on disk, the reloaded text is blank
+    writeFile("module n;\n  wire w;\nendmodule\n");
+    CHECK(manager.releaseUnusedText() == text.size() + 1);
+    string_view reloaded = manager.getSourceText(buffer.id);
+    CHECK(reloaded.size() == text.size() + 1);
+    CHECK(reloaded.substr(0, text.size()) == std::string(text.size(), ' '));
+    CHECK(manager.getLineNumber(loc) == 2);
+
+    fs::remove(path);
+}
+
+TEST_CASE("Releasing source text used by macro expansions") {
+    auto path = getTempPath("release_macro_test.sv");
+    std::string text = "`define FOO 1\nmodule m; int i = `FOO; endmodule\n";
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream.write(text.data(), (std::streamsize)text.size());
+    }
+
+    SourceManager manager;
+    auto expandFoo = [&] {
+        BumpAllocator localAlloc;
+        Diagnostics localDiags;
+        Preprocessor preprocessor(manager, localAlloc, localDiags);
+        preprocessor.pushSource(manager.readSource(path.string()));
+
+        SourceLocation loc;
+        while (true) {
+            Token token = preprocessor.next();
+            if (token.kind == TokenKind::EndOfFile)
+                break;
+            if (token.kind == TokenKind::IntegerLiteral)
+                loc = token.location();
+        }
+        return loc;
+    };
+
+    auto tree = SyntaxTree::fromFile(path.string(), manager);
+    SourceLocation loc = expandFoo();
+    REQUIRE(manager.isMacroLoc(loc));
+    CHECK(manager.getMacroName(loc) == "FOO");
+
+    // macro names outlive the text they were taken from
+    tree.reset();
+    CHECK(manager.releaseUnusedText() == text.size() + 1);
+    CHECK(manager.getMacroName(loc) == "FOO");
+
+    SourceLocation loc2 = expandFoo();
+    REQUIRE(manager.isMacroLoc(loc2));
+    CHECK(manager.getMacroName(loc2) == "FOO");
+    CHECK(manager.getMacroName(loc) == "FOO");
+
+    fs::remove(path);
+}
+
+TEST_CASE("Concurrent source loading") {
+    SourceManager manager;
+    std::string testPath = manager.makeAbsolutePath(string_view(getTestInclude()));
+
+    constexpr int NumThreads = 8;
+    constexpr int NumIterations = 200;
+
+    std::vector<SourceBuffer> buffers[NumThreads];
+    std::vector<SourceLocation> expansions[NumThreads];
+    std::vector<std::pair<size_t, size_t>> positions[NumThreads];
+    std::vector<std::thread> threads;
+    for (int i = 0; i < NumThreads; i++) {
+        threads.emplace_back([&, i] {
+            for (int j = 0; j < NumIterations; j++) {
+                auto file = manager.readSource(string_view(testPath));
+                auto header = manager.readHeader("nested/file.svh", SourceLocation(file.id, 0),
+                                                 false);
+                auto text = manager.assignText("`define FOO " + std::to_string(j));
+                auto loc = manager.createExpansionLoc(SourceLocation(text.id, 8),
+                                                      SourceLocation(file.id, 0),
+                                                      SourceLocation(file.id, 1), "FOO"sv);
+
+                // Queries on existing entries can run alongside other threads' writes.
+                // Catch assertions aren't thread safe, so results are checked after joining.
+                positions[i].emplace_back(manager.getLineNumber(loc),
+                                          manager.getColumnNumber(SourceLocation(text.id, 8)));
+
+                buffers[i].push_back(file);
+                buffers[i].push_back(header);
+                buffers[i].push_back(text);
+                expansions[i].push_back(loc);
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    std::set<BufferID> ids;
+    for (int i = 0; i < NumThreads; i++) {
+        for (auto& buffer : buffers[i]) {
+            REQUIRE(buffer);
+            CHECK(ids.insert(buffer.id).second);
+            CHECK(buffer.data == manager.getSourceText(buffer.id));
+        }
+        for (auto& [line, column] : positions[i]) {
+            CHECK(line == 1);
+            CHECK(column == 9);
+        }
+        for (auto& loc : expansions[i]) {
+            CHECK(manager.isMacroLoc(loc));
+            CHECK(manager.getMacroName(loc) == "FOO");
+            CHECK(ids.insert(loc.buffer()).second);
+        }
+    }
+
+    // files should only have been loaded once
+    CHECK(buffers[0][0].data.data() == buffers[NumThreads - 1][0].data.data());
+    CHECK(buffers[0][1].data.data() == buffers[NumThreads - 1][1].data.data());
+}
@@ -1,5 +1,8 @@
 #include "Test.h"
 
+#include <cstring>
+#include <fstream>
+
 #include "slang/syntax/SyntaxPrinter.h"
 
 TEST_CASE("Invalid chars") {
@@ -22,6 +25,48 @@ TEST_CASE("UTF8 chars") {
     CHECK(diagnostics.back().code == DiagCode::UTF8Char);
 }
 
+TEST_CASE("Invalid UTF8 sequences") {
+    // overlong, surrogate, stray continuation byte, and truncated at the end of the buffer
+    auto& text = "\xC0\xAF \xED\xA0\x80 \x80 \xE2\x82";
+
+    diagnostics.clear();
+    auto buffer = getSourceManager().assignText(text);
+    Lexer lexer(buffer, alloc, diagnostics);
+
+    std::vector<Token> tokens;
+    while (true) {
+        Token token = lexer.lex();
+        if (token.kind == TokenKind::EndOfFile)
+            break;
+        CHECK(token.kind == TokenKind::Unknown);
+        tokens.push_back(token);
+    }
+
+    REQUIRE(tokens.size() == 7);
+    CHECK(tokens.back().rawText() == "\xE2\x82");
+
+    // One warning for the buffer as a whole, then an error for each invalid piece.
+    std::vector<uint32_t> offsets = { 0, 0, 1, 3, 4, 5, 7, 9 };
+    REQUIRE(diagnostics.size() == offsets.size());
+    CHECK(diagnostics[0].code == DiagCode::InvalidSourceEncoding);
+    for (size_t i = 0; i < offsets.size(); i++) {
+        if (i)
+            CHECK(diagnostics[i].code == DiagCode::InvalidUTF8Seq);
+        CHECK(diagnostics[i].location.offset() == offsets[i]);
+    }
+}
+
+TEST_CASE("Non-UTF8 text in comments and strings") {
+    auto& text = "// caf\xC3\xA9\n\"\xE9t\xE9\"";
+    Token token = lexToken(text);
+
+    CHECK(token.kind == TokenKind::StringLiteral);
+    CHECK(token.valueText() == "\xE9t\xE9");
+    REQUIRE(diagnostics.size() == 1);
+    CHECK(diagnostics[0].code == DiagCode::InvalidSourceEncoding);
+    CHECK(diagnostics[0].location.offset() == 10);
+}
+
 TEST_CASE("Unicode BOMs") {
     lexToken("\xEF\xBB\xBF ");
     REQUIRE(!diagnostics.empty());
@@ -147,6 +192,23 @@ TEST_CASE("Block Comment (nested)") {
     CHECK(diagnostics.back().code == DiagCode::NestedBlockComment);
 }
 
+TEST_CASE("Long comments and whitespace") {
+    std::string str = std::string(70, ' ') + "/* " + std::string(100, 'a') + std::string(1, '\0') +
+                      std::string(40, 'b') + " */\t\t" + "// " + std::string(90, 'c') + "\n";
+    Token token = lexToken(string_view(str));
+
+    CHECK(token.kind == TokenKind::EndOfFile);
+    CHECK(token.toString() == str);
+    REQUIRE(token.trivia().size() == 5);
+    CHECK(token.trivia()[0].kind == TriviaKind::Whitespace);
+    CHECK(token.trivia()[0].getRawText().length() == 70);
+    CHECK(token.trivia()[1].kind == TriviaKind::BlockComment);
+    CHECK(token.trivia()[3].kind == TriviaKind::LineComment);
+    CHECK(token.trivia()[3].getRawText().length() == 93);
+    REQUIRE(diagnostics.size() == 1);
+    CHECK(diagnostics.back().code == DiagCode::EmbeddedNull);
+}
+
 TEST_CASE("Whitespace") {
     auto& text = " \t\v\f token";
     Token token = lexToken(text);
@@ -253,6 +315,48 @@ TEST_CASE("System Identifiers") {
     CHECK_DIAGNOSTICS_EMPTY;
 }
 
+TEST_CASE("Identifier interning") {
+    Token token = lexToken("interned_name");
+    IdentifierId id = token.identifierId();
+    CHECK(id != IdentifierId::Invalid);
+    CHECK(IdentifierTable::find("interned_name") == id);
+    CHECK(IdentifierTable::intern("interned_name") == id);
+    CHECK(IdentifierTable::getText(id) == "interned_name");
+    CHECK(IdentifierTable::getText(id).data() == IdentifierTable::getText(id).data());
+
+    // Escaped identifiers and macro usages are interned by their value text.
+    CHECK(lexToken("\\interned_name ").identifierId() == id);
+    CHECK(lexRawToken("`interned_name").identifierId() == id);
+    CHECK(lexRawToken("`\\interned_name ").identifierId() == id);
+
+    CHECK(lexToken("interned_name2").identifierId() != id);
+    CHECK(lexRawToken("`define").identifierId() == IdentifierId::Invalid);
+    CHECK(lexToken("123").identifierId() == IdentifierId::Invalid);
+
+    CHECK(IdentifierTable::find("never_seen_this_name") == IdentifierId::Invalid);
+    CHECK(IdentifierTable::find("") == IdentifierId::Invalid);
+    CHECK(IdentifierTable::intern("") == IdentifierId::Invalid);
+
+    // Identifiers are interned as they're lexed, even right after an integer base.
+    auto buffer = getSourceManager().assignText("'h abc_after_base");
+    Lexer lexer(buffer, alloc, diagnostics, LexerOptions{});
+    CHECK(lexer.lex().kind == TokenKind::IntegerBase);
+    Token digits = lexer.lex();
+    REQUIRE(digits.kind == TokenKind::Identifier);
+    CHECK(digits.getInfo()->identifierId != IdentifierId::Invalid);
+    CHECK(digits.getInfo()->identifierId == IdentifierTable::find("abc_after_base"));
+
+    // Looking up the ID of a token that wasn't lexed never adds to the table.
+    auto info = alloc.emplace<Token::Info>();
+    info->setRawText("never_interned_name");
+    info->extra.idType = IdentifierType::Normal;
+    size_t count = IdentifierTable::size();
+    CHECK(Token(TokenKind::Identifier, info).identifierId() == IdentifierId::Invalid);
+    CHECK(IdentifierTable::find("never_interned_name") == IdentifierId::Invalid);
+    CHECK(IdentifierTable::size() == count);
+    CHECK_DIAGNOSTICS_EMPTY;
+}
+
 TEST_CASE("Invalid escapes") {
     auto& text = "\\";
     Token token = lexToken(text);
@@ -385,6 +489,21 @@ TEST_CASE("Integer literal") {
     CHECK_DIAGNOSTICS_EMPTY;
 }
 
+TEST_CASE("Long decimal literals") {
+    Token token = lexToken("12_345_678_901");
+    CHECK(token.kind == TokenKind::IntegerLiteral);
+    CHECK(exactlyEqual(token.intValue(), SVInt(32, 12345678901ull, true)));
+
+    token = lexToken("123456781234567812345678.5e-16");
+    CHECK(token.kind == TokenKind::RealLiteral);
+    CHECK(token.realValue() == Approx(12345678.12345678));
+
+    token = lexToken("00000000000000001234567a");
+    CHECK(token.kind == TokenKind::IntegerLiteral);
+    CHECK(token.intValue() == 1234567);
+    CHECK_DIAGNOSTICS_EMPTY;
+}
+
 void checkVectorBase(const std::string& s, LiteralBase base, bool isSigned) {
     Token token = lexToken(string_view(s));
 
@@ -623,6 +742,236 @@ TEST_CASE("Too many errors") {
     CHECK(diagnostics.back().code == DiagCode::TooManyLexerErrors);
 }
 
+TEST_CASE("Discarding trivia") {
+    auto& text = "a  /* foo */ b // bar\n\n   \n  c /* x\n y */ d // baz \\\n\ne";
+
+    LexerOptions options;
+    options.preserveTrivia = false;
+
+    diagnostics.clear();
+    auto buffer = getSourceManager().assignText(text);
+    Lexer lexer(buffer, alloc, diagnostics, options);
+
+    CHECK(lexer.lex().trivia().empty());
+
+    Token b = lexer.lex();
+    REQUIRE(b.trivia().size() == 1);
+    CHECK(b.trivia()[0].kind == TriviaKind::Whitespace);
+    CHECK(b.trivia()[0].getRawText() == " ");
+
+    Token c = lexer.lex();
+    CHECK(c.valueText() == "c");
+    REQUIRE(c.trivia().size() == 1);
+    CHECK(c.trivia()[0].kind == TriviaKind::EndOfLine);
+
+    Token d = lexer.lex();
+    REQUIRE(d.trivia().size() == 1);
+    CHECK(d.trivia()[0].kind == TriviaKind::BlockComment);
+
+    Token e = lexer.lex();
+    REQUIRE(e.trivia().size() == 3);
+    CHECK(e.trivia()[0].kind == TriviaKind::LineComment);
+    CHECK(e.trivia()[1].kind == TriviaKind::EndOfLine);
+    CHECK(e.trivia()[2].kind == TriviaKind::EndOfLine);
+    CHECK_DIAGNOSTICS_EMPTY;
+}
+
+static std::vector<Token> lexWithCache(string_view text, TokenCache* cache,
+                                       KeywordVersion restVersion = getDefaultKeywordVersion()) {
+    LexerOptions options;
+    options.tokenCache = cache;
+
+    auto buffer = getSourceManager().assignText(text);
+    Lexer lexer(buffer, alloc, diagnostics, options);
+
+    // The first token is always lexed in the default version so that tests can
+    // switch versions partway through the buffer.
+    std::vector<Token> tokens;
+    tokens.push_back(lexer.lex());
+    while (tokens.back().kind != TokenKind::EndOfFile)
+        tokens.push_back(lexer.lex(restVersion));
+    return tokens;
+}
+
+static void checkSameTokens(const std::vector<Token>& actual, const std::vector<Token>& expected) {
+    REQUIRE(actual.size() == expected.size());
+    for (size_t i = 0; i < actual.size(); i++) {
+        const Token& a = actual[i];
+        const Token& e = expected[i];
+        CHECK(a.kind == e.kind);
+        CHECK(a.toString() == e.toString());
+        CHECK(a.valueText() == e.valueText());
+        CHECK(a.location().offset() == e.location().offset());
+        CHECK(a.identifierId() == e.identifierId());
+
+        REQUIRE(a.trivia().size() == e.trivia().size());
+        for (size_t j = 0; j < a.trivia().size(); j++)
+            CHECK(a.trivia()[j].kind == e.trivia()[j].kind);
+
+        switch (a.kind) {
+            case TokenKind::IntegerLiteral:
+                CHECK(exactlyEqual(a.intValue(), e.intValue()));
+                break;
+            case TokenKind::RealLiteral:
+                CHECK(a.realValue() == e.realValue());
+                break;
+            case TokenKind::TimeLiteral:
+                CHECK(a.realValue() == e.realValue());
+                CHECK(a.numericFlags().unit() == e.numericFlags().unit());
+                break;
+            case TokenKind::IntegerBase:
+                CHECK(a.numericFlags().raw == e.numericFlags().raw);
+                break;
+            case TokenKind::UnbasedUnsizedLiteral:
+                CHECK(exactlyEqual(a.bitValue(), e.bitValue()));
+                break;
+            case TokenKind::Identifier:
+                CHECK(a.identifierType() == e.identifierType());
+                break;
+            case TokenKind::Directive:
+            case TokenKind::MacroUsage:
+                CHECK(a.directiveKind() == e.directiveKind());
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+TEST_CASE("Token cache") {
+    auto dir = getTempPath("token_cache_test");
+
+    auto& text = "module m; /* comment */ logic [3:0] a = 4'sb1010 + 12;\n"
+                 "  real r = 1.5e3; time t = 10ns; wire w = 'x;\n"
+                 "  string s = \"a\\tb\"; initial $display(s, \\esc , `FOO);\n"
+                 "`define BAR 1 // trailing\n"
+                 "endmodule\n";
+
+    diagnostics.clear();
+    auto expected = lexWithCache(text, nullptr);
+
+    {
+        TokenCache cache(dir.string());
+        checkSameTokens(lexWithCache(text, &cache), expected);
+        CHECK(cache.getMissCount() == 1);
+        CHECK(cache.getHitCount() == 0);
+
+        checkSameTokens(lexWithCache(text, &cache), expected);
+        CHECK(cache.getHitCount() == 1);
+    }
+
+    // A new cache should find the entry written by the old one.
+    TokenCache cache(dir.string());
+    checkSameTokens(lexWithCache(text, &cache), expected);
+    CHECK(cache.getHitCount() == 1);
+    CHECK(cache.getMissCount() == 0);
+
+    // Changing the keyword version partway through stops replay at that point.
+    auto oldKeywords = lexWithCache(text, &cache, KeywordVersion::v1364_1995);
+    checkSameTokens(oldKeywords, lexWithCache(text, nullptr, KeywordVersion::v1364_1995));
+    CHECK(std::any_of(oldKeywords.begin(), oldKeywords.end(), [](const Token& t) {
+        return t.kind == TokenKind::Identifier && t.valueText() == "logic";
+    }));
+
+    // Files with lexer errors are never cached.
+    lexWithCache("module \x04 endmodule", &cache);
+    lexWithCache("module \x04 endmodule", &cache);
+    CHECK(cache.getMissCount() == 2);
+    CHECK(!diagnostics.empty());
+
+    // Lexers that stop early drop whatever they had recorded.
+    {
+        LexerOptions options;
+        options.tokenCache = &cache;
+        Lexer lexer(getSourceManager().assignText("module n; endmodule"), alloc, diagnostics,
+                    options);
+        lexer.lex();
+        CHECK(cache.getRecordingCount() == 1);
+    }
+    CHECK(cache.getRecordingCount() == 0);
+
+    {
+        Bag options;
+        LexerOptions lexerOptions;
+        lexerOptions.tokenCache = &cache;
+        options.add(lexerOptions);
+
+        Preprocessor preprocessor(getSourceManager(), alloc, diagnostics, options);
+        preprocessor.pushSource(getSourceManager().assignText("module n2; endmodule"));
+        preprocessor.next();
+        CHECK(cache.getRecordingCount() == 1);
+    }
+    CHECK(cache.getRecordingCount() == 0);
+
+    fs::remove_all(dir);
+}
+
+TEST_CASE("Token cache rejects corrupted files") {
+    auto dir = getTempPath("token_cache_corrupt_test");
+    auto& text = "`define FOO 1\nmodule m; // comment\nendmodule\n";
+
+    diagnostics.clear();
+    auto expected = lexWithCache(text, nullptr);
+    {
+        TokenCache cache(dir.string());
+        lexWithCache(text, &cache);
+    }
+
+    fs::path path = fs::directory_iterator(dir)->path();
+    std::string original;
+    {
+        std::ifstream stream(path, std::ios::binary);
+        original.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    }
+
+    // Offsets of the fields to corrupt, based on the layout in TokenCache.cpp.
+    constexpr size_t HeaderSize = 40;
+    constexpr size_t TokenSize = 32;
+    constexpr size_t TokenKindOffset = 24;
+    constexpr size_t TriviaKindOffset = 8;
+    uint32_t tokenCount, triviaCount;
+    memcpy(&tokenCount, original.data() + 24, sizeof(tokenCount));
+    memcpy(&triviaCount, original.data() + 28, sizeof(triviaCount));
+    REQUIRE(tokenCount == expected.size());
+    REQUIRE(triviaCount > 0);
+    REQUIRE(expected[0].kind == TokenKind::Directive);
+
+    auto checkRejected = [&](size_t offset, std::initializer_list<uint8_t> bytes) {
+        std::string data = original;
+        REQUIRE(offset + bytes.size() <= data.size());
+        memcpy(data.data() + offset, bytes.begin(), bytes.size());
+        {
+            std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+            stream.write(data.data(), (std::streamsize)data.size());
+        }
+
+        TokenCache cache(dir.string());
+        checkSameTokens(lexWithCache(text, &cache), expected);
+        CHECK(cache.getHitCount() == 0);
+        CHECK(cache.getMissCount() == 1);
+    };
+
+    // The unmodified file is used.
+    {
+        TokenCache cache(dir.string());
+        checkSameTokens(lexWithCache(text, &cache), expected);
+        CHECK(cache.getHitCount() == 1);
+    }
+
+    // An out of range token kind.
+    checkRejected(HeaderSize + TokenKindOffset, { 0xff, 0x7f });
+
+    // A directive kind that doesn't match the directive's text.
+    checkRejected(HeaderSize, { 0xff, 0xff, 0, 0 });
+
+    // An out of range trivia kind, and one that isn't plain text.
+    size_t triviaStart = HeaderSize + TokenSize * tokenCount;
+    checkRejected(triviaStart + TriviaKindOffset, { 0xee });
+    checkRejected(triviaStart + TriviaKindOffset, { uint8_t(TriviaKind::SkippedTokens) });
+
+    fs::remove_all(dir);
+}
+
 void testKeyword(TokenKind kind) {
     auto text = getTokenKindText(kind);
     Token token = lexToken(text);
@@ -885,6 +1234,22 @@ TEST_CASE("All Keywords") {
     testKeyword(TokenKind::XorKeyword);
 }
 
+TEST_CASE("Keyword tables") {
+    TokenKind kind;
+    CHECK(!getKeywordTable(KeywordVersion::v1364_2005)->lookup("logic", kind));
+    CHECK(getKeywordTable(KeywordVersion::v1800_2005)->lookup("logic", kind));
+    CHECK(kind == TokenKind::LogicKeyword);
+    CHECK(getKeywordTable(KeywordVersion::v1364_1995)->lookup("ifnone", kind));
+    CHECK(kind == TokenKind::IfNoneKeyword);
+    CHECK(!getKeywordTable(KeywordVersion::v1800_2017)->lookup("logicx", kind));
+    CHECK(!getKeywordTable(KeywordVersion::v1800_2017)->lookup("", kind));
+
+    CHECK(getKeywordVersion("1364-2001-noconfig") == KeywordVersion::v1364_2001_noconfig);
+    CHECK(!getKeywordVersion("1364-2001-"));
+    CHECK(getSystemKeywordKind("$unit") == TokenKind::UnitSystemName);
+    CHECK(getSystemKeywordKind("$units") == TokenKind::Unknown);
+}
+
 void testPunctuation(TokenKind kind) {
     string_view text = getTokenKindText(kind);
     Token token = lexToken(text);
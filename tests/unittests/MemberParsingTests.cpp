@@ -144,4 +144,38 @@ a1: assert property (@(posedge clk) a |-> p3);
     REQUIRE(coverStatement);
     REQUIRE(assertStatement);
     CHECK_DIAGNOSTICS_EMPTY;
-}
\ No newline at end of file
+}
+
+TEST_CASE("Parse multiple buffers in parallel") {
+    auto& sm = getSourceManager();
+    std::vector<SourceBuffer> buffers;
+    for (int i = 0; i < 32; i++) {
+        std::string text = "`include \"file_defn.svh\"\n"
+                           "module m" + std::to_string(i) + ";\n" +
+                           (i % 5 == 0 ? "`not_a_macro\n" : "") +
+                           "    wire [" + std::to_string(i) + ":0] w;\n"
+                           "endmodule\n";
+        buffers.push_back(sm.assignText(text));
+    }
+
+    auto trees = SyntaxTree::fromBuffers(buffers, sm, {}, 4);
+    REQUIRE(trees.size() == buffers.size());
+
+    for (size_t i = 0; i < trees.size(); i++) {
+        auto& root = trees[i]->root().as<CompilationUnitSyntax>();
+        REQUIRE(root.members.size() == 1);
+
+        auto& module = root.members[0]->as<ModuleDeclarationSyntax>();
+        CHECK(module.header->name.valueText() == "m" + std::to_string(i));
+
+        auto& diags = trees[i]->diagnostics();
+        if (i % 5 == 0) {
+            REQUIRE(!diags.empty());
+            for (auto& diag : diags)
+                CHECK(diag.location.buffer() == buffers[i].id);
+        }
+        else {
+            CHECK(diags.empty());
+        }
+    }
+}
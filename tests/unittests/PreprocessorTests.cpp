@@ -1,5 +1,7 @@
 #include "Test.h"
 
+#include <fstream>
+
 #include "slang/syntax/SyntaxPrinter.h"
 
 std::string preprocess(string_view text, string_view name = "source") {
@@ -576,6 +578,101 @@ foofoo
     CHECK_DIAGNOSTICS_EMPTY;
 }
 
+TEST_CASE("Repeated expansions of object-like macros") {
+    auto& text = R"(
+`define ADDR 32'h10
+`define BASE 4
+`define ID(a) a
+`define REG (`BASE + `ID(`ADDR))
+`REG `REG
+`undef BASE
+`REG
+`define BASE 8
+`REG
+`define ADDR 32'h20
+`REG `REG
+)";
+    auto& expected = R"(
+(4 + 32'h10) (4 + 32'h10)
+( + 32'h10)
+(8 + 32'h10)
+(8 + 32'h20) (8 + 32'h20)
+)";
+
+    std::string result = preprocess(text);
+    CHECK(result == expected);
+    REQUIRE(diagnostics.size() == 1);
+    CHECK(diagnostics[0].code == DiagCode::UnknownDirective);
+
+    // Each expansion still gets its own locations that lead back to its usage site,
+    // with the same chain of macro names as the original expansion.
+    auto& sm = getSourceManager();
+    Preprocessor preprocessor(sm, alloc, diagnostics);
+    preprocessor.pushSource(sm.assignText(R"(
+`define BASE 4
+`define ID(a) a
+`define REG (`BASE + `ID(12))
+`REG
+  `REG
+)"));
+
+    std::vector<Token> tokens;
+    for (Token token = preprocessor.next(); token.kind != TokenKind::EndOfFile;
+         token = preprocessor.next()) {
+        tokens.push_back(token);
+    }
+
+    REQUIRE(tokens.size() == 10);
+    for (size_t i = 0; i < 5; i++) {
+        Token first = tokens[i];
+        Token second = tokens[i + 5];
+        CHECK(first.valueText() == second.valueText());
+        CHECK(sm.getMacroName(first.location()) == sm.getMacroName(second.location()));
+        CHECK(sm.getFullyOriginalLoc(first.location()) ==
+              sm.getFullyOriginalLoc(second.location()));
+
+        SourceLocation firstUsage = sm.getFullyExpandedLoc(first.location());
+        SourceLocation secondUsage = sm.getFullyExpandedLoc(second.location());
+        CHECK(sm.getLineNumber(firstUsage) == 5);
+        CHECK(sm.getLineNumber(secondUsage) == 6);
+        CHECK(sm.getColumnNumber(secondUsage) == 3);
+    }
+}
+
+TEST_CASE("Repeated expansions of object-like macros that take trailing arguments") {
+    // The body of an object-like macro can end in a function-like macro whose
+    // arguments come from the source following each usage, so those expansions
+    // can't be replayed from a previous usage.
+    auto& text = R"(
+`define F(x) x
+`define ADD(a, b) a + b
+`define CAT(a, b) a``b
+`define STR(a) `"a`"
+`define DEF(a = 5) a
+`define G `F
+`define H `ADD
+`define J `CAT
+`define K `STR
+`define L `DEF
+`G(1) `G(2)
+`H(1, 2) `H(3, 4)
+`J(x, y) `J(u, v)
+`K(hi) `K(yo)
+`L() `L(7)
+)";
+    auto& expected = R"(
+1 2
+1 + 2 3 + 4
+xy uv
+"hi" "yo"
+5 7
+)";
+
+    std::string result = preprocess(text);
+    CHECK(result == expected);
+    CHECK_DIAGNOSTICS_EMPTY;
+}
+
 TEST_CASE("Macro with escaped name") {
     auto& text = R"(
 `define \FOO foo
@@ -749,6 +846,35 @@ TEST_CASE("Nested ifdef and macros") {
     CHECK_DIAGNOSTICS_EMPTY;
 }
 
+TEST_CASE("Inactive branch text") {
+    auto& disabled = "\n"
+                     "  // `endif in a comment\n"
+                     "  /* `else */ \"`endif in a \\\" string `elsif\"\n"
+                     "  \\esc`endif `\\`\" `\" `` `\\esc\n"
+                     "  `ifdef BAR 1 `else 2 `endif\n"
+                     "  $#@! \x04 'bad \"";
+    std::string text = std::string("`ifdef FOO") + disabled + "\n`else 42";
+    std::string fullText = text + "\n`endif";
+    Token token = lexToken(fullText);
+
+    REQUIRE(token.kind == TokenKind::IntegerLiteral);
+    CHECK(token.intValue() == 42);
+    CHECK_DIAGNOSTICS_EMPTY;
+
+    // The whole inactive branch, nested conditionals and all, is a single trivia span.
+    // The newline before the `else is part of the `else directive.
+    auto trivia = token.trivia();
+    REQUIRE(trivia.size() == 4);
+    CHECK(trivia[0].kind == TriviaKind::Directive);
+    CHECK(trivia[1].kind == TriviaKind::DisabledText);
+    CHECK(trivia[1].getRawText() == disabled);
+    CHECK(trivia[2].kind == TriviaKind::Directive);
+    CHECK(trivia[2].syntax()->kind == SyntaxKind::ElseDirective);
+
+    std::string str = SyntaxPrinter().setIncludeDirectives(true).print(token).str();
+    CHECK(str == text);
+}
+
 TEST_CASE("LINE Directive") {
     auto& text = "`__LINE__";
     Token token = lexToken(text);
@@ -767,6 +893,113 @@ TEST_CASE("LINE Directive as actual arg") {
     CHECK_DIAGNOSTICS_EMPTY;
 }
 
+TEST_CASE("Include guards") {
+    SourceManager manager;
+    auto testDir = findTestDir();
+    manager.addUserDirectory(string_view(testDir));
+
+    // Only the first of these has an include guard; the others have something
+    // active outside of the `ifndef block, or in an `else of it.
+    manager.setOverlay(testDir + "guarded.svh", "// header\n"
+                                                "`ifndef GUARDED_SVH\n"
+                                                "`define GUARDED_SVH\n"
+                                                "  `ifdef NOPE a `else b `endif\n"
+                                                "`endif // GUARDED_SVH\n");
+    manager.setOverlay(testDir + "trailing.svh", "`ifndef TRAILING_SVH\n"
+                                                 "`define TRAILING_SVH\n"
+                                                 "`endif\n"
+                                                 "c\n");
+    manager.setOverlay(testDir + "else.svh", "`ifndef ELSE_SVH\n"
+                                             "`define ELSE_SVH\n"
+                                             "`else\n"
+                                             "d\n"
+                                             "`endif\n");
+    manager.setOverlay(testDir + "leading.svh", "`define LEADING_SVH\n"
+                                                "`ifndef LEADING_SVH\n"
+                                                "`endif\n");
+
+    auto& text = "`include \"guarded.svh\"\n"
+                 "`include \"trailing.svh\"\n"
+                 "`include \"else.svh\"\n"
+                 "`include \"leading.svh\"\n"
+                 "`include \"guarded.svh\"\n"
+                 "`include \"trailing.svh\"\n"
+                 "`include \"else.svh\"\n"
+                 "`include \"leading.svh\"\n"
+                 "`undef GUARDED_SVH\n"
+                 "`include \"guarded.svh\"\n";
+
+    diagnostics.clear();
+    Preprocessor preprocessor(manager, alloc, diagnostics);
+    preprocessor.pushSource(manager.assignText(text));
+
+    std::string result;
+    while (true) {
+        Token token = preprocessor.next();
+        if (token.kind == TokenKind::EndOfFile)
+            break;
+        result += token.valueText();
+    }
+
+    CHECK(result == "bccdb");
+    CHECK_DIAGNOSTICS_EMPTY;
+
+    // The second include of the guarded file is skipped without lexing it.
+    CHECK(preprocessor.getSourceBuffers().size() == 9);
+}
+
+TEST_CASE("Include token cache") {
+    SourceManager manager;
+    auto testDir = findTestDir();
+    manager.addUserDirectory(string_view(testDir));
+    manager.setOverlay(testDir + "unguarded.svh", "// header\n"
+                                                  "localparam int `WIDTH = 8'd5;\n"
+                                                  "`ifdef NOPE \"a\" `else \"b\" `endif\n");
+
+    TokenCache cache;
+    PreprocessorOptions ppOptions;
+    ppOptions.includeTokenCache = &cache;
+    Bag options;
+    options.add(ppOptions);
+
+    auto& text = "`define WIDTH w\n"
+                 "`include \"unguarded.svh\"\n"
+                 "`include \"unguarded.svh\"\n";
+
+    // Each preprocessor includes the file twice; only the first include is lexed.
+    std::string results[2];
+    for (auto& result : results) {
+        diagnostics.clear();
+        Preprocessor preprocessor(manager, alloc, diagnostics, options);
+        preprocessor.pushSource(manager.assignText(text));
+
+        SmallVectorSized<BufferID, 2> buffers;
+        while (true) {
+            Token token = preprocessor.next();
+            if (token.kind == TokenKind::EndOfFile)
+                break;
+
+            result += token.toString();
+            if (token.kind == TokenKind::StringLiteral)
+                buffers.append(token.location().buffer());
+        }
+
+        CHECK_DIAGNOSTICS_EMPTY;
+
+        // Replayed tokens belong to the buffer they were included as.
+        REQUIRE(buffers.size() == 2);
+        CHECK(buffers[0] != buffers[1]);
+        CHECK(manager.getLineNumber(manager.getIncludedFrom(buffers[0])) == 2);
+        CHECK(manager.getLineNumber(manager.getIncludedFrom(buffers[1])) == 3);
+    }
+
+    CHECK(results[0] == results[1]);
+    CHECK(results[0] == "\n// header\nlocalparam int w = 8'd5;\n  \"b\" \n"
+                        "// header\nlocalparam int w = 8'd5;\n  \"b\"");
+    CHECK(cache.getMissCount() == 1);
+    CHECK(cache.getHitCount() == 3);
+}
+
 TEST_CASE("LINE Directive (include+nesting)") {
     auto& text = "`include \"local.svh\"\n"
                  "`define BAZ `__LINE__\n"
@@ -986,6 +1219,133 @@ TEST_CASE("timescale directive") {
     CHECK(!diagnostics.empty());
 }
 
+TEST_CASE("Preprocessor snapshot") {
+    auto& prelude = "`define FOO 1\n"
+                    "`define BAR(x) (x + `FOO)\n"
+                    "`define BAZ 3\n"
+                    "`undef BAZ\n"
+                    "`timescale 1ns / 1ps\n"
+                    "`default_nettype none\n"
+                    "`begin_keywords \"1364-2001\"\n";
+
+    diagnostics.clear();
+    PreprocessorOptions preludeOptions;
+    preludeOptions.predefines.push_back("PRE=2");
+    Bag preludeBag;
+    preludeBag.add(preludeOptions);
+
+    Preprocessor preludePP(getSourceManager(), alloc, diagnostics, preludeBag);
+    preludePP.pushSource(prelude);
+    while (preludePP.next().kind != TokenKind::EndOfFile) {
+    }
+    CHECK_DIAGNOSTICS_EMPTY;
+
+    auto snapshot = preludePP.snapshot();
+    CHECK(snapshot.getMacroCount() == 3);
+    CHECK(snapshot.isDefined("PRE"));
+    CHECK(!snapshot.isDefined("BAZ"));
+    CHECK(snapshot.getKeywordVersion() == KeywordVersion::v1364_2001);
+    CHECK(snapshot.getDefaultNetType() == TokenKind::Unknown);
+    REQUIRE(snapshot.getTimescale().has_value());
+    CHECK(snapshot.getTimescale()->base.unit == TimeUnit::Nanoseconds);
+
+    PreprocessorOptions ppOptions;
+    ppOptions.snapshot = &snapshot;
+    ppOptions.predefines.push_back("EXTRA=4");
+    Bag options;
+    options.add(ppOptions);
+
+    // Changes made by one preprocessor don't affect the snapshot or any others.
+    for (int i = 0; i < 2; i++) {
+        Preprocessor preprocessor(getSourceManager(), alloc, diagnostics, options);
+        preprocessor.pushSource("`BAR(`PRE) `EXTRA logic\n"
+                                "`undef FOO\n"
+                                "`end_keywords\n"
+                                "`resetall\n");
+
+        std::string result;
+        while (true) {
+            Token token = preprocessor.next();
+            if (token.kind == TokenKind::EndOfFile)
+                break;
+            result += token.toString();
+            if (token.valueText() == "logic")
+                CHECK(token.kind == TokenKind::Identifier);
+        }
+
+        CHECK_DIAGNOSTICS_EMPTY;
+        CHECK(result == "(2 + 1) 4 logic");
+        CHECK(!preprocessor.isDefined("FOO"));
+        CHECK(preprocessor.isDefined("__LINE__"));
+        CHECK(!preprocessor.getTimescale());
+        CHECK(preprocessor.getDefaultNetType() == TokenKind::WireKeyword);
+    }
+
+    CHECK(snapshot.isDefined("FOO"));
+}
+
+TEST_CASE("Preprocessor snapshot retains prelude text") {
+    auto path = fs::temp_directory_path() / "slang_snapshot_prelude.svh";
+    std::string prelude = "`define WIDTH 8\n";
+    {
+        std::ofstream stream(path, std::ios::binary);
+        stream.write(prelude.data(), (std::streamsize)prelude.size());
+    }
+
+    SourceManager sourceManager;
+    BumpAllocator localAlloc;
+    Diagnostics localDiags;
+    optional<PreprocessorSnapshot> snapshot;
+    {
+        Preprocessor preludePP(sourceManager, localAlloc, localDiags);
+        preludePP.pushSource(sourceManager.readSource(path.string()));
+        while (preludePP.next().kind != TokenKind::EndOfFile) {
+        }
+        snapshot = preludePP.snapshot();
+    }
+
+    // The macro bodies point into the prelude's text, so it can't be released
+    // until the snapshot (and every copy of it) is gone.
+    CHECK(sourceManager.releaseUnusedText() == 0);
+
+    PreprocessorOptions ppOptions;
+    ppOptions.snapshot = &*snapshot;
+    Bag options;
+    options.add(ppOptions);
+
+    // Syntax trees built from the snapshot have tokens that point into the prelude.
+    auto tree = SyntaxTree::fromText("localparam int p = `WIDTH;", sourceManager, "source",
+                                     options);
+    CHECK(tree->diagnostics().empty());
+
+    auto preprocessor = std::make_unique<Preprocessor>(sourceManager, localAlloc, localDiags,
+                                                       options);
+    preprocessor->pushSource(sourceManager.assignText("`WIDTH"));
+    CHECK(preprocessor->next().toString() == "8");
+
+    // A snapshot taken from a preprocessor that started from another one keeps
+    // the original prelude alive as well.
+    auto chained = std::make_unique<PreprocessorSnapshot>(preprocessor->snapshot());
+    snapshot.reset();
+    CHECK(sourceManager.releaseUnusedText() == 0);
+
+    // So does the preprocessor itself, and the tree, even once all of the
+    // snapshots are gone.
+    chained.reset();
+    CHECK(sourceManager.releaseUnusedText() == 0);
+
+    preprocessor.reset();
+    CHECK(sourceManager.releaseUnusedText() == 0);
+
+    CHECK(SyntaxPrinter().print(*tree).str() == "localparam int p = 8;");
+
+    tree.reset();
+    CHECK(sourceManager.releaseUnusedText() == prelude.size() + 1);
+    CHECK(localDiags.empty());
+
+    fs::remove(path);
+}
+
 TEST_CASE("macro-defined include file") {
     auto& text = "`define FILE <include.svh>\n"
                  "`include `FILE";
@@ -1028,4 +1388,76 @@ TEST_CASE("Preprocessor API") {
     CHECK(pp.isDefined("FOO"));
     CHECK(pp.undefine("FOO"));
     CHECK(!pp.isDefined("FOO"));
-}
\ No newline at end of file
+}
+TEST_CASE("Discarding trivia (full tree)") {
+    auto& text = R"(
+`define FOO(a, b) a + \
+    b // comment \
+    + 1
+`define BAR (3) /* one line */
+`define STR(x) `"x`"
+module m;   // some comment
+    /* another comment */   int i = `FOO(1,   2);
+
+
+    logic [3:0] j = 4'b 1010;
+    string s = `STR(a    b);
+    int k = `BAR;
+endmodule
+)";
+
+    LexerOptions lexerOptions;
+    lexerOptions.preserveTrivia = false;
+
+    Bag options;
+    options.add(lexerOptions);
+
+    auto tree = SyntaxTree::fromText(text, SyntaxTree::getDefaultSourceManager(), "source",
+                                     options);
+    CHECK(tree->diagnostics().empty());
+
+    // Printing still works but produces normalized text.
+    CHECK(SyntaxPrinter().print(*tree).str() == R"(
+module m;
+int i = 1 + 
+ 2// comment \
++ 1;
+logic [3:0] j = 4'b 1010;
+string s = "a b";
+int k = (3);
+endmodule
+)");
+}
+
+TEST_CASE("Invalid encoding in a header is reported once") {
+    auto dir = fs::temp_directory_path() / "slang_encoding_test";
+    fs::create_directories(dir);
+    std::string header = "int i;\n// \xC3\x28\n";
+    {
+        std::ofstream stream(dir / "bad_encoding.svh", std::ios::binary);
+        stream.write(header.data(), (std::streamsize)header.size());
+    }
+
+    SourceManager sourceManager;
+    sourceManager.addUserDirectory(string_view(dir.string()));
+
+    BumpAllocator localAlloc;
+    Diagnostics localDiags;
+    Preprocessor preprocessor(sourceManager, localAlloc, localDiags);
+    preprocessor.pushSource(sourceManager.assignText(R"(
+`include "bad_encoding.svh"
+`include "bad_encoding.svh"
+`include "bad_encoding.svh"
+)"));
+    while (preprocessor.next().kind != TokenKind::EndOfFile) {
+    }
+
+    REQUIRE(localDiags.size() == 1);
+    CHECK(localDiags[0].code == DiagCode::InvalidSourceEncoding);
+
+    auto& loc = localDiags[0].location;
+    CHECK(fs::path(sourceManager.getRawFileName(loc.buffer())).filename() == "bad_encoding.svh");
+    CHECK(loc.offset() == header.find('\xC3'));
+
+    fs::remove_all(dir);
+}
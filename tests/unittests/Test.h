@@ -6,7 +6,9 @@
         disable : 4459) // annoying warning about global "alloc" being shadowed by locals
 #endif
 
+#include <atomic>
 #include <catch2/catch.hpp>
+#include <random>
 #include <sstream>
 
 #include "slang/binding/Expressions.h"
@@ -69,6 +71,15 @@ inline std::string findTestDir() {
     return (path / "tests/unittests/data/").string();
 }
 
+/// Gets a path in the system temp directory that ends in the given name but is otherwise
+/// unique, so that test runs going on in parallel don't clobber each other's files.
+inline fs::path getTempPath(string_view name) {
+    static std::atomic<uint32_t> counter = 0;
+    std::random_device rd;
+    std::string prefix = "slang_" + std::to_string(rd()) + "_" + std::to_string(counter++) + "_";
+    return fs::temp_directory_path() / (prefix + std::string(name));
+}
+
 inline SourceManager& getSourceManager() {
     static SourceManager* sourceManager = nullptr;
     if (!sourceManager) {
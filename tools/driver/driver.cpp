@@ -6,15 +6,21 @@
 //------------------------------------------------------------------------------
 
 #include <CLI/CLI.hpp>
+#include <atomic>
+#include <chrono>
 #include <fmt/format.h>
 #include <nlohmann/json.hpp>
+#include <thread>
+#include <unordered_set>
 
 #include "slang/compilation/Compilation.h"
 #include "slang/diagnostics/DiagnosticWriter.h"
 #include "slang/parsing/Preprocessor.h"
 #include "slang/syntax/SyntaxPrinter.h"
 #include "slang/syntax/SyntaxTree.h"
+#include "slang/syntax/SyntaxVisitor.h"
 #include "slang/text/SourceManager.h"
+#include "slang/util/CommandLine.h"
 
 using namespace slang;
 
@@ -40,6 +46,76 @@ void writeToFile(const std::string& fileName, const std::string& contents) {
         fclose(fp);
 }
 
+/// Runs @a worker on @a numThreads threads (including the calling one) and waits
+/// for all of them to finish.
+template<typename TFunc>
+static void runParallel(uint32_t numThreads, TFunc&& worker) {
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < numThreads; i++)
+        threads.emplace_back(worker);
+
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+/// Calls @a func for every index in [0, count), spread across @a numThreads threads.
+template<typename TFunc>
+static void parallelFor(size_t count, uint32_t numThreads, TFunc&& func) {
+    std::atomic<size_t> next = 0;
+    runParallel((uint32_t)std::min(size_t(numThreads), std::max(count, size_t(1))), [&] {
+        size_t i;
+        while ((i = next++) < count)
+            func(i);
+    });
+}
+
+/// Finds library files (-y) in the given directories. For each file name with one of
+/// the given extensions, maps the name (without the extension) to the file's path;
+/// when the same name appears in multiple directories, the first one listed wins.
+static std::unordered_map<std::string, fs::path> indexLibraryDirs(
+    const std::vector<std::string>& dirs, const std::vector<std::string>& extensions,
+    uint32_t numThreads) {
+
+    std::vector<std::vector<fs::path>> dirFiles(dirs.size());
+    parallelFor(dirs.size(), numThreads, [&](size_t i) {
+        std::error_code ec;
+        for (auto it = fs::directory_iterator(dirs[i], ec); !ec && it != fs::directory_iterator();
+             it.increment(ec)) {
+            std::string ext = it->path().extension().string();
+            if (std::find(extensions.begin(), extensions.end(), ext) != extensions.end() &&
+                it->is_regular_file(ec)) {
+                dirFiles[i].push_back(it->path());
+            }
+        }
+    });
+
+    std::unordered_map<std::string, fs::path> results;
+    for (auto& files : dirFiles) {
+        std::sort(files.begin(), files.end());
+        for (auto& file : files)
+            results.try_emplace(file.stem().string(), file);
+    }
+    return results;
+}
+
+/// Collects the names of all definitions declared and instantiated in a syntax tree.
+class DefinitionNameCollector : public SyntaxVisitor<DefinitionNameCollector> {
+public:
+    std::unordered_set<std::string> declared;
+    std::unordered_set<std::string> instantiated;
+
+    void handle(const ModuleHeaderSyntax& header) {
+        declared.emplace(header.name.valueText());
+        visitDefault(header);
+    }
+
+    void handle(const HierarchyInstantiationSyntax& instantiation) {
+        instantiated.emplace(instantiation.type.valueText());
+        visitDefault(instantiation);
+    }
+};
+
 bool runPreprocessor(SourceManager& sourceManager, const Bag& options,
                      const std::vector<SourceBuffer>& buffers) {
     BumpAllocator alloc;
@@ -72,11 +148,37 @@ bool runPreprocessor(SourceManager& sourceManager, const Bag& options,
 }
 
 bool runCompiler(SourceManager& sourceManager, const Bag& options,
-                 const std::vector<SourceBuffer>& buffers, const std::string& astJsonFile) {
+                 const std::vector<SourceBuffer>& buffers, const std::string& astJsonFile,
+                 const std::unordered_map<std::string, fs::path>& libraryFiles,
+                 uint32_t numThreads) {
 
     Compilation compilation;
-    for (const SourceBuffer& buffer : buffers)
-        compilation.addSyntaxTree(SyntaxTree::fromBuffer(buffer, sourceManager, options));
+    DefinitionNameCollector names;
+    std::unordered_set<std::string> loadedLibraryFiles;
+
+    std::vector<SourceBuffer> toParse = buffers;
+    while (!toParse.empty()) {
+        for (auto& tree : SyntaxTree::fromBuffers(toParse, sourceManager, options, numThreads)) {
+            if (!libraryFiles.empty())
+                tree->root().visit(names);
+            compilation.addSyntaxTree(tree);
+        }
+
+        // Pull in library files for any definitions that are instantiated but haven't
+        // been declared yet, which may in turn instantiate other library definitions.
+        toParse.clear();
+        for (auto& name : names.instantiated) {
+            if (names.declared.count(name) || !loadedLibraryFiles.insert(name).second)
+                continue;
+
+            auto it = libraryFiles.find(name);
+            if (it != libraryFiles.end()) {
+                SourceBuffer buffer = sourceManager.readSource(it->second.string());
+                if (buffer)
+                    toParse.push_back(buffer);
+            }
+        }
+    }
 
     auto& diagnostics = compilation.getAllDiagnostics();
     DiagnosticWriter writer(sourceManager);
@@ -96,13 +198,20 @@ int main(int argc, char** argv) try {
     std::vector<std::string> includeSystemDirs;
     std::vector<std::string> defines;
     std::vector<std::string> undefines;
+    std::vector<std::string> libDirs;
+    std::vector<std::string> libExts;
 
     std::string astJsonFile;
+    std::string tokenCacheDir;
 
     bool onlyPreprocess;
+    bool cacheIncludes = false;
+    bool showTiming = false;
+    uint32_t numThreads = 0;
 
     CLI::App cmd("SystemVerilog compiler");
-    cmd.add_option("files", sourceFiles, "Source files to compile");
+    cmd.add_option("files", sourceFiles,
+                   "Source files to compile; these can be glob patterns using *, ?, and **");
     cmd.add_option("-I,--include-directory", includeDirs, "Additional include search paths");
     cmd.add_option("--include-system-directory", includeSystemDirs,
                    "Additional system include search paths");
@@ -110,14 +219,48 @@ int main(int argc, char** argv) try {
                    "Define <macro>=<value> (or 1 if <value> ommitted) in all source files");
     cmd.add_option("-U,--undefine-macro", undefines,
                    "Undefine macro name at the start of all source files");
+    cmd.add_option("-y,--libdir", libDirs,
+                   "Library directories in which to search for missing module definitions");
+    cmd.add_option("--libext", libExts,
+                   "File extensions of library files (.v and .sv if none are given)");
     cmd.add_flag("-E,--preprocess", onlyPreprocess,
                  "Only run the preprocessor (and print preprocessed files to stdout)");
 
     cmd.add_option("--ast-json", astJsonFile,
                    "Dump the compiled AST in JSON format to the specified file, or '-' for stdout");
+    cmd.add_option("-j,--threads", numThreads,
+                   "Number of threads to use when loading and parsing source files, "
+                   "or 0 to use one per core");
+    cmd.add_option("--token-cache", tokenCacheDir,
+                   "Directory in which to cache lexed tokens, so that files that haven't "
+                   "changed since a previous run don't need to be lexed again");
+    cmd.add_flag("--cache-includes", cacheIncludes,
+                 "Keep the tokens of included files in memory, so that files that are "
+                 "included more than once don't need to be lexed again");
+    cmd.add_flag("--timing", showTiming, "Print how long each stage of compilation takes");
+    cmd.footer("Options can also be read from command files: -f <file> for files whose paths\n"
+               "are relative to the current directory, and -F <file> for files whose paths\n"
+               "are relative to the command file. +incdir+, +define+, and +libext+ are\n"
+               "also accepted.");
+
+    std::vector<std::string> args;
+    try {
+        std::vector<std::string> input(argv + 1, argv + argc);
+        std::vector<std::string> warnings;
+        args = expandCommandLine(input, warnings);
+        for (auto& warning : warnings)
+            fmt::print(stderr, "warning: {}\n", warning);
+    }
+    catch (const std::exception& e) {
+        fmt::print(stderr, "error: {}\n", e.what());
+        return 1;
+    }
 
     try {
-        cmd.parse(argc, argv);
+        std::vector<char*> expandedArgv{ argv[0] };
+        for (auto& arg : args)
+            expandedArgv.push_back(arg.data());
+        cmd.parse((int)expandedArgv.size(), expandedArgv.data());
     }
     catch (const CLI::ParseError& e) {
         return cmd.exit(e);
@@ -135,20 +278,84 @@ int main(int argc, char** argv) try {
     ppoptions.undefines = undefines;
     ppoptions.predefineSource = "<command-line>";
 
+    TokenCache includeCache;
+    if (cacheIncludes)
+        ppoptions.includeTokenCache = &includeCache;
+
+    // Trivia is only needed to print source text back out, which only happens
+    // when we're just running the preprocessor.
+    LexerOptions lexerOptions;
+    lexerOptions.preserveTrivia = onlyPreprocess;
+
+    std::unique_ptr<TokenCache> tokenCache;
+    if (!tokenCacheDir.empty()) {
+        tokenCache = std::make_unique<TokenCache>(tokenCacheDir);
+        lexerOptions.tokenCache = tokenCache.get();
+    }
+
     Bag options;
     options.add(ppoptions);
+    options.add(lexerOptions);
+
+    if (numThreads == 0)
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
 
+    // Resolve the full set of source files. Everything here hits the file system,
+    // so it's all done in parallel.
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::vector<std::string> patterns;
+    for (auto& file : sourceFiles) {
+        if (isGlobPattern(file))
+            patterns.push_back(file);
+    }
+
+    auto globResults = expandGlobs(patterns, numThreads);
+
+    std::vector<std::string> fileNames;
+    size_t patternIndex = 0;
+    for (auto& file : sourceFiles) {
+        if (!isGlobPattern(file)) {
+            fileNames.push_back(file);
+            continue;
+        }
+
+        auto& matches = globResults[patternIndex++];
+        if (matches.empty())
+            fmt::print(stderr, "warning: no files matched '{}'\n", file);
+        for (auto& match : matches)
+            fileNames.push_back(match.string());
+    }
+
+    std::vector<SourceBuffer> loaded(fileNames.size());
+    parallelFor(fileNames.size(), numThreads,
+                [&](size_t i) { loaded[i] = sourceManager.readSource(fileNames[i]); });
+
+    if (libExts.empty())
+        libExts = { ".v", ".sv" };
+    auto libraryFiles = indexLibraryDirs(libDirs, libExts, numThreads);
+
+    // Files can be named more than once (e.g. explicitly and by a glob pattern);
+    // filter out the duplicates so that they don't get compiled twice.
     bool anyErrors = false;
     std::vector<SourceBuffer> buffers;
-    for (const std::string& file : sourceFiles) {
-        SourceBuffer buffer = sourceManager.readSource(file);
-        if (!buffer) {
-            fmt::print("error: no such file or directory: '{}'\n", file);
+    std::unordered_set<string_view> seenFiles;
+    for (size_t i = 0; i < fileNames.size(); i++) {
+        if (!loaded[i]) {
+            fmt::print("error: no such file or directory: '{}'\n", fileNames[i]);
             anyErrors = true;
             continue;
         }
 
-        buffers.push_back(buffer);
+        if (seenFiles.insert(sourceManager.getRawFileName(loaded[i].id)).second)
+            buffers.push_back(loaded[i]);
+    }
+
+    auto resolveTime = std::chrono::steady_clock::now();
+    if (showTiming) {
+        fmt::print("resolved {} source files and {} library files in {:.3f}s\n", buffers.size(),
+                   libraryFiles.size(),
+                   std::chrono::duration<double>(resolveTime - startTime).count());
     }
 
     if (buffers.empty()) {
@@ -160,13 +367,20 @@ int main(int argc, char** argv) try {
         if (onlyPreprocess)
             anyErrors |= !runPreprocessor(sourceManager, options, buffers);
         else
-            anyErrors |= !runCompiler(sourceManager, options, buffers, astJsonFile);
+            anyErrors |= !runCompiler(sourceManager, options, buffers, astJsonFile, libraryFiles,
+                                      numThreads);
     }
     catch (const std::exception& e) {
         fmt::print("internal compiler error: {}\n", e.what());
         return 2;
     }
 
+    if (showTiming) {
+        fmt::print("compiled in {:.3f}s\n", std::chrono::duration<double>(
+                                                 std::chrono::steady_clock::now() - resolveTime)
+                                                 .count());
+    }
+
     return anyErrors ? 1 : 0;
 }
 catch (const std::exception& e) {